@@ -12,36 +12,78 @@
 #ifndef CEDO_BACKEND_BACKEND_H
 #define CEDO_BACKEND_BACKEND_H
 
+#include <charconv>
+#include <cstring>
 #include <iosfwd>
-#include <sstream>
+#include <memory>
+#include <string_view>
+#include <type_traits>
 
 #include "cedo/Binfmt/Binfmt.h"
 
+// Text is formatted straight into a large buffer, which is written out to a
+// file descriptor, or a stream, when it fills up. Directives and labels start
+// on a new line, ending the previous one if it wasn't.
 class AsmStreamer {
-  std::ostream &underlyingStream;
-  std::stringstream currentLine;
+  static constexpr size_t bufferSize = 1 << 20;
+  // The most any single integer takes.
+  static constexpr size_t maxIntSize = 24;
+
+  int fd = -1;
+  std::ostream *underlyingStream = nullptr;
+  std::unique_ptr<char[]> buffer{new char[bufferSize]};
+  char *current = buffer.get();
+  char *const bufferEnd = buffer.get() + bufferSize;
+  // Whether the last character written ended a line, or nothing was written.
+  bool atLineStart = true;
+  bool failed = false;
 
   static constexpr char spaces[17] = "                ";
   static constexpr int tabSize = 4;
   static constexpr std::string_view tab{spaces, tabSize};
 
+  // Writes out the buffer, followed by extra if it's given.
+  void writeBuffer(std::string_view extra = {});
+
+  void endLine() {
+    if (!atLineStart)
+      *this << '\n';
+  }
+
+  void writeByteList(const uint8_t *start, const uint8_t *end);
+  void writeEscaped(const uint8_t *start, const uint8_t *end);
+
+  template <typename T>
+  static constexpr bool isInteger =
+      std::is_integral<T>::value && !std::is_same<T, bool>::value &&
+      !std::is_same<T, char>::value && !std::is_same<T, signed char>::value &&
+      !std::is_same<T, unsigned char>::value;
+
 public:
+  AsmStreamer(int fd) : fd(fd) {}
   AsmStreamer(std::ostream &underlyingStream)
-      : underlyingStream(underlyingStream) {}
+      : underlyingStream(&underlyingStream) {}
+  AsmStreamer(const AsmStreamer &) = delete;
+  AsmStreamer &operator=(const AsmStreamer &) = delete;
   ~AsmStreamer() { flush(); }
 
+  // Ends the current line and writes out everything so far.
   void flush() {
-    if (!currentLine.str().size())
-      return;
-    if (*currentLine.str().rbegin() != '\n')
-      currentLine << '\n';
-    underlyingStream << currentLine.str();
-    currentLine.str(std::string{});
+    endLine();
+    writeBuffer();
   }
 
+  // Whether writing to the file descriptor or stream failed.
+  bool hasFailed() const { return failed; }
+
+  // Values are written as lists of up to this many per directive.
+  static constexpr size_t valuesPerLine = 16;
+
   struct Tab {};
   struct Directive : public std::string_view {};
   struct Label : public std::string_view {};
+  // A string operand, quoted and escaped like the strings RawBytes writes.
+  struct Quoted : public std::string_view {};
 
   struct RawBytes {
     const uint8_t *start;
@@ -54,43 +96,65 @@ public:
     static constexpr Directive directive{".byte"};
   };
 
-  template <typename T> AsmStreamer &operator<<(T t) {
-    currentLine << t;
+  AsmStreamer &operator<<(char c) {
+    if (current == bufferEnd)
+      writeBuffer();
+    *current++ = c;
+    atLineStart = c == '\n';
     return *this;
   }
 
-  template <> AsmStreamer &operator<<<Tab>(Tab) {
-    currentLine << tab;
+  AsmStreamer &operator<<(std::string_view str) {
+    if (str.empty())
+      return *this;
+    if (str.size() > static_cast<size_t>(bufferEnd - current)) {
+      writeBuffer(str);
+    } else {
+      std::memcpy(current, str.data(), str.size());
+      current += str.size();
+    }
+    atLineStart = str.back() == '\n';
     return *this;
   }
 
-  AsmStreamer &operator<<(Directive d) {
-    flush();
-    *this << Tab{} << d.data();
+  AsmStreamer &operator<<(const char *str) {
+    return *this << std::string_view{str};
+  }
+
+  template <typename T>
+  std::enable_if_t<isInteger<T>, AsmStreamer &> operator<<(T value) {
+    if (static_cast<size_t>(bufferEnd - current) < maxIntSize)
+      writeBuffer();
+    current = std::to_chars(current, bufferEnd, value).ptr;
+    atLineStart = false;
     return *this;
   }
 
+  AsmStreamer &operator<<(Tab) { return *this << tab; }
+
+  AsmStreamer &operator<<(Directive d) {
+    endLine();
+    return *this << Tab{} << static_cast<std::string_view>(d);
+  }
+
   AsmStreamer &operator<<(Label l) {
-    flush();
-    *this << l.data();
+    endLine();
+    *this << static_cast<std::string_view>(l);
     if (*l.rbegin() != ':')
       *this << ':';
-    *this << '\n';
-    return *this;
+    return *this << '\n';
   }
 
   AsmStreamer &operator<<(const Byte &byte) {
-    *this << Byte::directive << ' ' << (int)byte.byte << '\n';
-    return *this;
+    return *this << Byte::directive << ' ' << static_cast<int>(byte.byte)
+                 << '\n';
   }
 
-  AsmStreamer &operator<<(const RawBytes &rawBytes) {
-    for (const uint8_t *curr = rawBytes.start,
-                       *end = rawBytes.start + rawBytes.size;
-         curr < end; curr++)
-      *this << Byte{*curr};
-    return *this;
-  }
+  AsmStreamer &operator<<(const Quoted &quoted);
+
+  // Runs of printable characters are written as strings, with .string if a
+  // null byte ends them. Other bytes are written as .byte lists.
+  AsmStreamer &operator<<(const RawBytes &rawBytes);
 };
 
 #endif // CEDO_BACKEND_BACKEND_H
@@ -14,18 +14,25 @@
 
 #include <iosfwd>
 #include <memory>
+#include <optional>
 #include <string>
 #include <string_view>
 #include <tuple>
+#include <unordered_map>
 #include <vector>
 #include <map>
 
 #include "cedo/Backend/AsmStreamer.h"
+#include "cedo/Backend/LayoutPlan.h"
 #include "cedo/Binfmt/Type.h"
 #include "cedo/Binfmt/Binfmt.h"
 
 using SymName = std::string;
-using Sym = std::tuple<SymName, std::unique_ptr<Type>, const void *>;
+// The type is owned by whatever TypeGraph it came from.
+using Sym = std::tuple<SymName, const Type *, const void *>;
+
+// The alignment a symbol is given in the output.
+size_t findAlignment(const Sym &sym);
 
 class AsmEmitter {
   Triple outputTriple;
@@ -38,12 +45,31 @@ class AsmEmitter {
 
   void emitOneSym(const Sym &sym);
 
+  // Plans are compiled the first time an object of their type is emitted.
+  std::unordered_map<const Type *, LayoutPlan> layoutPlans;
+
+  // Where large pointer-free ranges are written, if anywhere.
+  struct IncbinFile {
+    int fd;
+    std::string path;
+    uint64_t threshold;
+    uint64_t size = 0;
+    bool failed = false;
+  };
+  std::optional<IncbinFile> incbinFile;
+
   void emitObject(const Type &type, const uint8_t *addr);
+  // Runs of steps without pointers are written to incbinFile if findIncbin is
+  // set and they're large enough.
+  void emitSteps(const LayoutPlan::Step *step, const LayoutPlan::Step *end,
+                 const uint8_t *addr, bool findIncbin);
+  void emitIncbin(const uint8_t *addr, uint64_t size);
 
-  void emitPointerType(const Type& type, const uint8_t *addr);
-  void emitTypeWithChildren(const Type &type, const uint8_t *addr);
+  void emitPointer(const uint8_t *addr);
 
-  void emitValueForIntegralType(const Type& type, const uint8_t *addr);
+  void emitValue(size_t byteSize, const uint8_t *addr);
+  // Runs of values are written as lists, and bytes as strings where they can.
+  void emitValues(size_t byteSize, uint64_t count, const uint8_t *addr);
   void emitForSize(size_t size, const uint8_t *addr);
 
   void registerKnownSyms(const std::vector<Sym> &symList);
@@ -51,8 +77,23 @@ class AsmEmitter {
 public:
   AsmEmitter(Triple outputTriple, std::ostream &os)
     : outputTriple(outputTriple), stream(os) {}
+  AsmEmitter(Triple outputTriple, int fd)
+    : outputTriple(outputTriple), stream(fd) {}
+
+  // Ranges of threshold bytes or more without pointers are written to fd as is
+  // and included with .incbin from path, instead of as directives. path should
+  // be relative to where the output will be assembled. Padding inside those
+  // ranges keeps whatever bytes the object had, where it's otherwise zeroed.
+  void setIncbinFile(int fd, std::string path, uint64_t threshold) {
+    incbinFile = IncbinFile{fd, std::move(path), threshold};
+  }
 
   void emitAsm(const std::vector<Sym> &symList, std::string_view versionStr = {});
+
+  // Whether writing the output, or the incbin file, failed.
+  bool hasFailed() const {
+    return stream.hasFailed() || (incbinFile && incbinFile->failed);
+  }
 };
 
 #endif // CEDO_BACKEND_EMITASM_H
@@ -0,0 +1,77 @@
+// Copyright 2021 Alex Brachet (alex@brachet.dev)
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CEDO_BACKEND_EMITOBJECT_H
+#define CEDO_BACKEND_EMITOBJECT_H
+
+#include <cstdint>
+#include <iosfwd>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "cedo/Backend/EmitAsm.h"
+#include "cedo/Backend/LayoutPlan.h"
+#include "cedo/Binfmt/Binfmt.h"
+#include "cedo/Core/Error.h"
+
+// Writes symbols straight to a relocatable object, with the same contents
+// assembling AsmEmitter's output would give. Objects go in .data, pointers to
+// other output symbols are relocations against them and the version goes in
+// .comment.
+class ObjectEmitter {
+  Triple outputTriple;
+  int fd = -1;
+  std::ostream *underlyingStream = nullptr;
+  bool failed = false;
+
+  struct Reloc {
+    uint64_t offset;
+    uint32_t symIndex;
+  };
+
+  // Symbol table indices of the output symbols, by their address.
+  std::unordered_map<uint64_t, uint32_t> symIndices;
+  std::vector<uint8_t> data;
+  std::vector<Reloc> relocs;
+
+  // Plans are compiled the first time an object of their type is added.
+  std::unordered_map<const Type *, LayoutPlan> layoutPlans;
+
+  // Copies the object into data at offset. Padding is left as zeros.
+  void addObject(const Type &type, const uint8_t *addr, uint64_t offset);
+  void addSteps(const LayoutPlan::Step *step, const LayoutPlan::Step *end,
+                const uint8_t *addr, uint64_t offset);
+
+  void write(const void *bytes, size_t size);
+  void writeZeros(size_t size);
+
+  template <typename ELFT>
+  void writeFile(const std::vector<Sym> &symList,
+                 const std::vector<uint64_t> &symOffsets,
+                 std::string_view versionStr);
+
+public:
+  ObjectEmitter(Triple outputTriple, std::ostream &os)
+      : outputTriple(outputTriple), underlyingStream(&os) {}
+  ObjectEmitter(Triple outputTriple, int fd)
+      : outputTriple(outputTriple), fd(fd) {}
+
+  // Only little endian x86 objects can be written, ELF64 or ELF32 depending on
+  // the address size.
+  Error emitObjectFile(const std::vector<Sym> &symList,
+                       std::string_view versionStr = {});
+
+  // Whether writing the output failed.
+  bool hasFailed() const { return failed; }
+};
+
+#endif // CEDO_BACKEND_EMITOBJECT_H
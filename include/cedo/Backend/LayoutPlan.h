@@ -0,0 +1,53 @@
+// Copyright 2021 Alex Brachet (alex@brachet.dev)
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CEDO_BACKEND_LAYOUTPLAN_H
+#define CEDO_BACKEND_LAYOUTPLAN_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "cedo/Binfmt/Type.h"
+
+// A type's layout flattened into the steps needed to emit an object of it, so
+// the type graph is walked once per type instead of once per object. Scalars
+// next to each other are coalesced into runs and arrays repeat their element's
+// steps, so a plan's size doesn't depend on the number of elements.
+struct LayoutPlan {
+  struct Step {
+    enum Kind : uint8_t {
+      // count scalars of size bytes each, back to back.
+      Values,
+      // A pointer, emitted as the symbol it points to.
+      Pointer,
+      // size bytes of padding. Members which overlap make it negative.
+      Padding,
+      // The numSteps steps after this one, count times, size bytes apart.
+      Repeat,
+    };
+
+    Kind kind;
+    // Whether any of a Repeat's steps is a Pointer.
+    bool hasPointers;
+    uint32_t numSteps;
+    // From the start of the object, or of the element for steps in a Repeat.
+    uint64_t offset;
+    int64_t size;
+    uint64_t count;
+  };
+
+  std::vector<Step> steps;
+
+  static LayoutPlan compile(const Type &type);
+};
+
+#endif // CEDO_BACKEND_LAYOUTPLAN_H
@@ -12,16 +12,18 @@
 #ifndef CEDO_BINFMT_BINFMT_H
 #define CEDO_BINFMT_BINFMT_H
 
+#include <cstdint>
 #include <memory>
 #include <optional>
+#include <string_view>
 
 #include "cedo/Core/FileReader.h"
 
-enum class FileFormat {
+enum class FileFormat : uint8_t {
   ELF,
 };
 
-enum class AddressSize {
+enum class AddressSize : uint8_t {
   Eight,
   Four,
 };
@@ -31,15 +33,15 @@ inline size_t getAddrSize(AddressSize as) {
   return as == AddressSize::Eight ? 8 : 4;
 }
 
-enum class Endianness {
+enum class Endianness : uint8_t {
   Little,
   Big,
 };
 
 struct Triple {
-  FileFormat fileFormat : 4;
-  AddressSize addrSize : 2;
-  Endianness endianness : 2;
+  FileFormat fileFormat;
+  AddressSize addrSize;
+  Endianness endianness;
 };
 
 class ObjectFileReader {
@@ -53,6 +55,9 @@ public:
   const FileReader &getFileReader() const { return file; }
 
   virtual Triple getTriple() const = 0;
+
+  // The raw bytes of the object's build ID, or empty if it doesn't have one.
+  virtual std::string_view getBuildID() const { return {}; }
 };
 
 std::optional<Triple> findFileTriple(const FileReader &file);
@@ -15,63 +15,184 @@
 #include <algorithm>
 #include <cstdint>
 #include <memory>
+#include <optional>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <utility>
 #include <variant>
 #include <vector>
 
 #include "cedo/Binfmt/Binfmt.h"
 #include "cedo/Binfmt/DWARFConstants.h"
+#include "cedo/Binfmt/DebugFile.h"
 #include "cedo/Binfmt/Type.h"
+#include "cedo/Core/Arena.h"
 
 class DWARFReader;
+class SupplementaryFile;
+class TypeUnits;
 
 class DWARF {
   friend class DWARFReader;
-
-  using Data = std::variant<uint64_t, std::string>;
+  friend class SupplementaryFile;
+  friend class TypeUnits;
+
+  // Strings are views into the object file's mapping.
+  using Data = std::variant<uint64_t, std::string_view>;
+
+  struct Attribute {
+    DW_AT attr;
+    bool isString;
+    // A DW_FORM_ref_sig8 reference, value is the type unit's signature.
+    bool isSignature;
+    // If isString this is a pointer to a null terminated string in the object
+    // file, or 0 if it couldn't be resolved.
+    uint64_t value;
+
+    Data getData() const {
+      if (!isString)
+        return value;
+      const char *str = reinterpret_cast<const char *>(value);
+      return str ? std::string_view{str} : std::string_view{};
+    }
+  };
 
   struct DIE {
-    using Info = std::vector<std::pair<DW_AT, Data>>;
-
-    DW_TAG tag;
     uint64_t offset;
-    Info info;
-    std::vector<uint64_t> childrenOffsets;
-
+    // Allocated in DWARF::attributeArena.
+    const Attribute *attrs;
+    uint16_t numAttrs;
+    DW_TAG tag;
+    // Distance to the next sibling in DWARF::debugInfo, 0 for the last child.
+    uint32_t siblingDelta : 31;
+    uint32_t hasChildren : 1;
+
+    // DIEs are stored in the order they were read, so the first child always
+    // immediately follows its parent.
+    class ChildIterator {
+      const DIE *die;
+
+    public:
+      ChildIterator(const DIE *die) : die(die) {}
+      const DIE &operator*() const { return *die; }
+      const DIE *operator->() const { return die; }
+      ChildIterator &operator++() {
+        die = die->siblingDelta ? die + die->siblingDelta : nullptr;
+        return *this;
+      }
+      bool operator!=(const ChildIterator &other) const {
+        return die != other.die;
+      }
+    };
+
+    struct ChildRange {
+      const DIE *first;
+      ChildIterator begin() const { return first; }
+      ChildIterator end() const { return nullptr; }
+    };
+
+    ChildRange children() const { return {hasChildren ? this + 1 : nullptr}; }
+    const Attribute *findAttribute(DW_AT attr) const;
     std::optional<Data> getAttributeIfPresent(DW_AT attr) const;
   };
 
+  struct VariableRef {
+    size_t dieIndex;
+    bool isDeclaration;
+
+    VariableRef(size_t dieIndex, bool isDeclaration)
+        : dieIndex(dieIndex), isDeclaration(isDeclaration) {}
+  };
+
   uint16_t version;
   AddressSize addrSize;
+  // Files other than the object the debug info was read from, a separate debug
+  // file or split DWARF files, which it points into.
+  std::vector<std::shared_ptr<const ObjectFileReader>> files;
   const uint8_t *debugInfoStart;
   std::vector<DIE> debugInfo;
-
-  std::unique_ptr<Type> getTypeFromBaseTypeDie(const DIE &die) const;
-  std::unique_ptr<Type> getTypeFromArrayDie(const DIE &die) const;
-  std::unique_ptr<Type> getTypeFromStructTypeDie(const DIE &typeDie) const;
-  std::unique_ptr<Type> getTypeFromTypeDie(const DIE &die) const;
-  std::unique_ptr<Type> getTypeFromPointerTypeDie(const DIE &die) const;
+  Arena attributeArena;
+  // Variable DIEs by name, fully qualified name ("ns::table") and linkage
+  // name. Built while parsing.
+  std::unordered_map<std::string, VariableRef> variableIndex;
+  // Types are resolved on demand and memoized by DIE offset, so every variable
+  // of a type shares it.
+  std::shared_ptr<TypeGraph> typeGraph = std::make_shared<TypeGraph>();
+  mutable std::unordered_map<uint64_t, const Type *> typeCache;
+  // Type units from .debug_types, or .debug_info since DWARF 5, by signature.
+  // They're only read once a DW_FORM_ref_sig8 reference reaches them, their
+  // DIEs aren't in debugInfo.
+  std::shared_ptr<TypeUnits> typeUnits;
+  // DWARF that dwz moved into a file shared with other objects. Its DIEs are
+  // only read once a reference reaches them, and aren't in debugInfo either.
+  std::shared_ptr<SupplementaryFile> supFile;
+
+  const Type *getTypeFromBaseTypeDie(const DIE &die) const;
+  const Type *getTypeFromArrayDie(const DIE &die) const;
+  const Type *getTypeFromStructTypeDie(const DIE &typeDie) const;
+  const Type *getTypeFromTypeDie(const DIE &die) const;
+  const Type *getTypeFromPointerTypeDie(const DIE &die) const;
 
   const DIE *getTypeDieFromDie(const DIE &die) const;
+  const DIE *findVariable(std::string_view name) const;
+  // The type DIE of the type unit with signature, reading the unit if it
+  // hasn't been yet.
+  const DIE *getTypeUnitDIE(uint64_t signature) const;
+  const DIE *getTypeUnitDIEFromOffset(uint64_t offset) const;
+  const DIE *getSupplementaryDIEFromOffset(uint64_t offset) const;
   const DIE *getDIEFromOffset(uint64_t offset) const {
-    DWARF *mutableThis = const_cast<DWARF *>(this);
-    return mutableThis->getDIEFromOffset(offset);
-  }
-  DIE *getDIEFromOffset(uint64_t offset) {
-    auto it =
-        std::find_if(debugInfo.begin(), debugInfo.end(),
-                     [offset](const DIE &d) { return d.offset == offset; });
-    return it == debugInfo.end() ? nullptr : std::addressof(*it);
+    // DIEs are read in order so debugInfo is sorted by offset.
+    auto it = std::lower_bound(
+        debugInfo.begin(), debugInfo.end(), offset,
+        [](const DIE &d, uint64_t offset) { return d.offset < offset; });
+    if (it != debugInfo.end() && it->offset == offset)
+      return std::addressof(*it);
+    // References from inside a type unit are to its own DIEs.
+    if (typeUnits)
+      if (const DIE *die = getTypeUnitDIEFromOffset(offset))
+        return die;
+    return supFile ? getSupplementaryDIEFromOffset(offset) : nullptr;
   }
 
 public:
+  enum class ParseMode {
+    // Every DIE is read.
+    Full,
+    // Functions and everything in them are skipped over, only what can be
+    // reached from global variables is read.
+    VariablesAndTypes,
+  };
+
+  // The DWARF refers to strings in the object file, so objectFileReader needs
+  // to outlive it. If the object's debug info is in a separate file, see
+  // openDebugFile, it is read from there instead.
   static ErrorOr<DWARF>
-  readFromObject(const ObjectFileReader &objectFileReader);
+  readFromObject(const ObjectFileReader &objectFileReader,
+                 ParseMode mode = ParseMode::Full,
+                 const DebugFileOptions &debugFileOptions = {});
 
-  std::unique_ptr<Type> getVariableType(std::string_view sym_name) const;
+  // Only reads the units which define names, using the object's name index
+  // (.debug_names, .gdb_index or .debug_pubnames) to find them. Falls back to
+  // reading every unit if there is no index or it doesn't have every name.
+  static ErrorOr<DWARF>
+  readFromObject(const ObjectFileReader &objectFileReader,
+                 const std::vector<std::string_view> &names,
+                 ParseMode mode = ParseMode::VariablesAndTypes,
+                 const DebugFileOptions &debugFileOptions = {});
+
+  // The type is owned by getTypeGraph(). This isn't thread safe, since types
+  // are resolved lazily.
+  const Type *getVariableType(std::string_view sym_name) const;
+
+  // Returns the name the variable has in the symbol table, which is its
+  // linkage name if it has one. This is empty if the variable isn't found.
+  std::string_view getVariableLinkageName(std::string_view sym_name) const;
 
   const std::vector<DIE> &getDebugInfo() const { return debugInfo; }
+
+  // Types can be held onto after the DWARF and its object file are gone.
+  std::shared_ptr<const TypeGraph> getTypeGraph() const { return typeGraph; }
 };
 
 #endif // CEDO_BINFMT_DWARF_H
@@ -21,23 +21,30 @@ enum class DWARFType {
   Zero = 0,
   One = 1,
   Two = 2,
+  Three = 3,
   Four = 4,
   Eight = 8,
+  Sixteen = 16,
 
   DWARFAddr,   // Based on the AddressSize of the current section
   MachineAddr, // Based on the AddressSize of the ObjectFile
   String,
-  StringPtr, // This is DWARFAddr
+  StringPtr,     // This is DWARFAddr
+  LineStringPtr, // DWARFAddr into .debug_line_str
   LEB128,
   ULEB128,
   Indirect,
-  Exprloc
+  Exprloc,
+  Block,  // ULEB128 length
+  Block1, // One byte length
+  Block2,
+  Block4
 };
 
 // Generate in utils/DWARFConstants/GenConstants.py
 
 struct DW_TAG {
-  uint8_t value;
+  uint16_t value;
   constexpr operator decltype(value)() const { return value; }
 };
 
@@ -102,6 +109,14 @@ constexpr DW_TAG DW_TAG_shared_type{0x40};
 constexpr DW_TAG DW_TAG_type_unit{0x41};
 constexpr DW_TAG DW_TAG_rvalue_reference_type{0x42};
 constexpr DW_TAG DW_TAG_template_alias{0x43};
+constexpr DW_TAG DW_TAG_coarray_type{0x44};
+constexpr DW_TAG DW_TAG_generic_subrange{0x45};
+constexpr DW_TAG DW_TAG_dynamic_type{0x46};
+constexpr DW_TAG DW_TAG_atomic_type{0x47};
+constexpr DW_TAG DW_TAG_call_site{0x48};
+constexpr DW_TAG DW_TAG_call_site_parameter{0x49};
+constexpr DW_TAG DW_TAG_skeleton_unit{0x4a};
+constexpr DW_TAG DW_TAG_immutable_type{0x4b};
 
 struct DW_CHILDREN {
   uint8_t value;
@@ -112,7 +127,7 @@ constexpr DW_CHILDREN DW_CHILDREN_no{0x00};
 constexpr DW_CHILDREN DW_CHILDREN_yes{0x01};
 
 struct DW_AT {
-  uint8_t value;
+  uint16_t value;
   constexpr operator decltype(value)() const { return value; }
 };
 
@@ -211,23 +226,58 @@ constexpr DW_AT DW_AT_data_bit_offset{0x6b};
 constexpr DW_AT DW_AT_const_expr{0x6c};
 constexpr DW_AT DW_AT_enum_class{0x6d};
 constexpr DW_AT DW_AT_linkage_name{0x6e};
+constexpr DW_AT DW_AT_string_length_bit_size{0x6f};
+constexpr DW_AT DW_AT_string_length_byte_size{0x70};
+constexpr DW_AT DW_AT_rank{0x71};
+constexpr DW_AT DW_AT_str_offsets_base{0x72};
+constexpr DW_AT DW_AT_addr_base{0x73};
+constexpr DW_AT DW_AT_rnglists_base{0x74};
+constexpr DW_AT DW_AT_dwo_name{0x76};
+constexpr DW_AT DW_AT_reference{0x77};
+constexpr DW_AT DW_AT_rvalue_reference{0x78};
+constexpr DW_AT DW_AT_macros{0x79};
+constexpr DW_AT DW_AT_call_all_calls{0x7a};
+constexpr DW_AT DW_AT_call_all_source_calls{0x7b};
+constexpr DW_AT DW_AT_call_all_tail_calls{0x7c};
+constexpr DW_AT DW_AT_call_return_pc{0x7d};
+constexpr DW_AT DW_AT_call_value{0x7e};
+constexpr DW_AT DW_AT_call_origin{0x7f};
+constexpr DW_AT DW_AT_call_parameter{0x80};
+constexpr DW_AT DW_AT_call_pc{0x81};
+constexpr DW_AT DW_AT_call_tail_call{0x82};
+constexpr DW_AT DW_AT_call_target{0x83};
+constexpr DW_AT DW_AT_call_target_clobbered{0x84};
+constexpr DW_AT DW_AT_call_data_location{0x85};
+constexpr DW_AT DW_AT_call_data_value{0x86};
+constexpr DW_AT DW_AT_noreturn{0x87};
+constexpr DW_AT DW_AT_alignment{0x88};
+constexpr DW_AT DW_AT_export_symbols{0x89};
+constexpr DW_AT DW_AT_deleted{0x8a};
+constexpr DW_AT DW_AT_defaulted{0x8b};
+constexpr DW_AT DW_AT_loclists_base{0x8c};
+constexpr DW_AT DW_AT_GNU_dwo_name{0x2130};
+constexpr DW_AT DW_AT_GNU_dwo_id{0x2131};
+constexpr DW_AT DW_AT_GNU_ranges_base{0x2132};
+constexpr DW_AT DW_AT_GNU_addr_base{0x2133};
+constexpr DW_AT DW_AT_GNU_pubnames{0x2134};
+constexpr DW_AT DW_AT_GNU_pubtypes{0x2135};
 
 struct DW_FORM {
-  uint8_t value;
+  uint16_t value;
   DWARFType type;
   constexpr operator decltype(value)() const { return value; }
 };
 
 constexpr std::array DW_FORM_static_list{
     DW_FORM{0x01, DWARFType::MachineAddr},
-    DW_FORM{0x03, static_cast<DWARFType>(2)},
-    DW_FORM{0x04, static_cast<DWARFType>(4)},
+    DW_FORM{0x03, DWARFType::Block2},
+    DW_FORM{0x04, DWARFType::Block4},
     DW_FORM{0x05, static_cast<DWARFType>(2)},
     DW_FORM{0x06, static_cast<DWARFType>(4)},
     DW_FORM{0x07, static_cast<DWARFType>(8)},
     DW_FORM{0x08, DWARFType::String},
-    DW_FORM{0x09, DWARFType::LEB128},
-    DW_FORM{0x0a, static_cast<DWARFType>(1)},
+    DW_FORM{0x09, DWARFType::Block},
+    DW_FORM{0x0a, DWARFType::Block1},
     DW_FORM{0x0b, static_cast<DWARFType>(1)},
     DW_FORM{0x0c, static_cast<DWARFType>(1)},
     DW_FORM{0x0d, DWARFType::LEB128},
@@ -243,7 +293,29 @@ constexpr std::array DW_FORM_static_list{
     DW_FORM{0x17, DWARFType::DWARFAddr},
     DW_FORM{0x18, DWARFType::Exprloc},
     DW_FORM{0x19, static_cast<DWARFType>(0)},
-    DW_FORM{0x20, static_cast<DWARFType>(8)}};
+    DW_FORM{0x20, static_cast<DWARFType>(8)},
+    DW_FORM{0x1a, DWARFType::ULEB128},
+    DW_FORM{0x1b, DWARFType::ULEB128},
+    DW_FORM{0x1c, static_cast<DWARFType>(4)},
+    DW_FORM{0x1d, DWARFType::DWARFAddr},
+    DW_FORM{0x1e, static_cast<DWARFType>(16)},
+    DW_FORM{0x1f, DWARFType::LineStringPtr},
+    DW_FORM{0x21, static_cast<DWARFType>(0)},
+    DW_FORM{0x22, DWARFType::ULEB128},
+    DW_FORM{0x23, DWARFType::ULEB128},
+    DW_FORM{0x24, static_cast<DWARFType>(8)},
+    DW_FORM{0x25, static_cast<DWARFType>(1)},
+    DW_FORM{0x26, static_cast<DWARFType>(2)},
+    DW_FORM{0x27, static_cast<DWARFType>(3)},
+    DW_FORM{0x28, static_cast<DWARFType>(4)},
+    DW_FORM{0x29, static_cast<DWARFType>(1)},
+    DW_FORM{0x2a, static_cast<DWARFType>(2)},
+    DW_FORM{0x2b, static_cast<DWARFType>(3)},
+    DW_FORM{0x2c, static_cast<DWARFType>(4)},
+    DW_FORM{0x1f01, DWARFType::ULEB128},
+    DW_FORM{0x1f02, DWARFType::ULEB128},
+    DW_FORM{0x1f20, DWARFType::DWARFAddr},
+    DW_FORM{0x1f21, DWARFType::DWARFAddr}};
 constexpr DW_FORM DW_FORM_form_addr = DW_FORM_static_list[0];
 constexpr DW_FORM DW_FORM_block2 = DW_FORM_static_list[1];
 constexpr DW_FORM DW_FORM_block4 = DW_FORM_static_list[2];
@@ -269,6 +341,35 @@ constexpr DW_FORM DW_FORM_sec_offset = DW_FORM_static_list[21];
 constexpr DW_FORM DW_FORM_exprloc = DW_FORM_static_list[22];
 constexpr DW_FORM DW_FORM_flag_present = DW_FORM_static_list[23];
 constexpr DW_FORM DW_FORM_ref_sig8 = DW_FORM_static_list[24];
+constexpr DW_FORM DW_FORM_strx = DW_FORM_static_list[25];
+constexpr DW_FORM DW_FORM_addrx = DW_FORM_static_list[26];
+constexpr DW_FORM DW_FORM_ref_sup4 = DW_FORM_static_list[27];
+constexpr DW_FORM DW_FORM_strp_sup = DW_FORM_static_list[28];
+constexpr DW_FORM DW_FORM_data16 = DW_FORM_static_list[29];
+constexpr DW_FORM DW_FORM_line_strp = DW_FORM_static_list[30];
+constexpr DW_FORM DW_FORM_implicit_const = DW_FORM_static_list[31];
+constexpr DW_FORM DW_FORM_loclistx = DW_FORM_static_list[32];
+constexpr DW_FORM DW_FORM_rnglistx = DW_FORM_static_list[33];
+constexpr DW_FORM DW_FORM_ref_sup8 = DW_FORM_static_list[34];
+constexpr DW_FORM DW_FORM_strx1 = DW_FORM_static_list[35];
+constexpr DW_FORM DW_FORM_strx2 = DW_FORM_static_list[36];
+constexpr DW_FORM DW_FORM_strx3 = DW_FORM_static_list[37];
+constexpr DW_FORM DW_FORM_strx4 = DW_FORM_static_list[38];
+constexpr DW_FORM DW_FORM_addrx1 = DW_FORM_static_list[39];
+constexpr DW_FORM DW_FORM_addrx2 = DW_FORM_static_list[40];
+constexpr DW_FORM DW_FORM_addrx3 = DW_FORM_static_list[41];
+constexpr DW_FORM DW_FORM_addrx4 = DW_FORM_static_list[42];
+constexpr DW_FORM DW_FORM_GNU_addr_index = DW_FORM_static_list[43];
+constexpr DW_FORM DW_FORM_GNU_str_index = DW_FORM_static_list[44];
+constexpr DW_FORM DW_FORM_GNU_ref_alt = DW_FORM_static_list[45];
+constexpr DW_FORM DW_FORM_GNU_strp_alt = DW_FORM_static_list[46];
+
+constexpr bool is_DW_FORM(decltype(DW_FORM::value) value) {
+  for (const auto &a : DW_FORM_static_list)
+    if (a.value == value)
+      return true;
+  return false;
+}
 
 constexpr DW_FORM get_DW_FORM(decltype(DW_FORM::value) value) {
   for (const auto &a : DW_FORM_static_list)
@@ -0,0 +1,53 @@
+// Copyright 2021 Alex Brachet (alex@brachet.dev)
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CEDO_BINFMT_DEBUGFILE_H
+#define CEDO_BINFMT_DEBUGFILE_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "cedo/Binfmt/Binfmt.h"
+#include "cedo/Core/ErrorOr.h"
+
+// Where to look for debug info that has been split out of an object into its
+// own file.
+struct DebugFileOptions {
+  // Used instead of searching when it isn't empty.
+  std::string debugFile;
+  // The object's path. .gnu_debuglink names are relative to its directory.
+  std::string objectPath;
+  // Searched for .build-id/xx/yyyy.debug files and .gnu_debuglink names.
+  std::vector<std::string> debugDirs = {"/usr/lib/debug"};
+};
+
+// Opens the file with objectFileReader's debug info. This is the explicitly
+// given one, or if the object has no .debug_info of its own the first file
+// found by build ID or .gnu_debuglink whose build ID or CRC matches. Returns
+// null if the object's own debug info should be used.
+ErrorOr<std::unique_ptr<ObjectFileReader>>
+openDebugFile(const ObjectFileReader &objectFileReader,
+              const DebugFileOptions &options);
+
+// Opens the supplementary file dwz moved DWARF shared by several objects into,
+// named by the object's .gnu_debugaltlink or .debug_sup section. It's looked
+// for relative to the object's directory, then by build ID in debugDirs.
+// Returns null if the object doesn't name one.
+ErrorOr<std::unique_ptr<ObjectFileReader>>
+openSupplementaryFile(const ObjectFileReader &objectFileReader,
+                      const DebugFileOptions &options);
+
+// The CRC used by .gnu_debuglink.
+uint32_t debugLinkCRC32(const uint8_t *data, size_t size, uint32_t crc = 0);
+
+#endif // CEDO_BINFMT_DEBUGFILE_H
@@ -13,7 +13,13 @@
 #define CEDO_BINFMT_TYPE_H
 
 #include <cstdint>
+#include <memory>
+#include <new>
 #include <string>
+#include <utility>
+#include <vector>
+
+#include "cedo/Core/Arena.h"
 
 class Type {
   uint8_t qualifiers;
@@ -117,12 +123,11 @@ private:
   };
 
 public:
-  std::unique_ptr<Type> elementType;
+  const Type *elementType;
   size_t numElements;
 
-  ArrayType(uint8_t qualifiers, std::unique_ptr<Type> &&elementType,
-            size_t numElements)
-      : Type(qualifiers | Type::Qualifier::Array), elementType(std::move(elementType)),
+  ArrayType(uint8_t qualifiers, const Type *elementType, size_t numElements)
+      : Type(qualifiers | Type::Qualifier::Array), elementType(elementType),
         numElements(numElements) {}
 
   size_t getObjectSize() const override {
@@ -141,7 +146,7 @@ public:
 class StructType : public Type, public HasChildTypes {
 public:
   using MemberOffset = off_t;
-  using Member = std::pair<std::unique_ptr<Type>, MemberOffset>;
+  using Member = std::pair<const Type *, MemberOffset>;
 
 private:
   struct iterator_impl : public HasChildTypes::iterator_impl {
@@ -184,10 +189,12 @@ public:
 };
 
 struct PointerType : public Type {
-  std::unique_ptr<Type> pointingType;
+  // Null for void pointers. This is set after the pointer is created, so
+  // types can point back to themselves.
+  const Type *pointingType;
 
-  PointerType(uint8_t qualifiers, std::unique_ptr<Type> &&pointingType)
-    : Type(qualifiers | Type::Qualifier::Pointer), pointingType(std::move(pointingType)) {}
+  PointerType(uint8_t qualifiers, const Type *pointingType)
+    : Type(qualifiers | Type::Qualifier::Pointer), pointingType(pointingType) {}
 
   size_t getObjectSize() const override {
     // TODO: Need to do something about this...
@@ -195,4 +202,31 @@ struct PointerType : public Type {
   }
 };
 
+// Owns types which refer to each other by pointer. Types are never freed or
+// moved until the graph is destroyed, so they can point to each other in
+// cycles.
+class TypeGraph {
+  Arena arena;
+  std::vector<Type *> types;
+
+public:
+  TypeGraph() = default;
+  TypeGraph(const TypeGraph &) = delete;
+  TypeGraph &operator=(const TypeGraph &) = delete;
+
+  ~TypeGraph() {
+    for (Type *type : types)
+      type->~Type();
+  }
+
+  template <typename T, typename... Args> T *create(Args &&...args) {
+    T *type = new (arena.allocate(sizeof(T), alignof(T)))
+        T(std::forward<Args>(args)...);
+    types.push_back(type);
+    return type;
+  }
+
+  size_t size() const { return types.size(); }
+};
+
 #endif // CEDO_BINFMT_TYPE_H
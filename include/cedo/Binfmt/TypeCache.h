@@ -0,0 +1,79 @@
+// Copyright 2021 Alex Brachet (alex@brachet.dev)
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CEDO_BINFMT_TYPECACHE_H
+#define CEDO_BINFMT_TYPECACHE_H
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "cedo/Binfmt/Binfmt.h"
+#include "cedo/Binfmt/Type.h"
+#include "cedo/Core/ErrorOr.h"
+#include "cedo/Core/FileReader.h"
+
+// Variables' linkage names and types saved from an earlier run, so they don't
+// need to be read from DWARF again. The file is a header followed by flat
+// arrays of fixed size records which refer to each other by index, it's read
+// in place from its mapping. Only the types reachable from the variables
+// looked up get created.
+class TypeCache {
+public:
+  struct Variable {
+    std::string name;
+    std::string linkageName;
+    const Type *type;
+  };
+
+private:
+  struct Header;
+  struct VariableRecord;
+  struct TypeRecord;
+  struct MemberRecord;
+
+  FileReader file;
+  const Header *header;
+  const VariableRecord *variables;
+  const TypeRecord *types;
+  const MemberRecord *members;
+  const char *strings;
+  std::shared_ptr<TypeGraph> typeGraph = std::make_shared<TypeGraph>();
+  // Types created so far by their index.
+  std::vector<const Type *> createdTypes;
+
+  TypeCache(FileReader &&file) : file(std::move(file)) {}
+
+  std::string_view getString(uint32_t offset, uint32_t size) const;
+  const Type *createType(uint32_t index);
+
+public:
+  // The file name to use for an object in a cache directory. This is its build
+  // ID, or a hash of the whole file if it doesn't have one.
+  static std::string getFileName(const ObjectFileReader &objectFileReader);
+
+  static ErrorOr<TypeCache> open(std::string_view path);
+  // Overwrites path atomically, so readers never see a partial file.
+  static std::string write(std::string_view path,
+                           const std::vector<Variable> &variables);
+
+  // Finds a variable by the name it was saved under. Its type is owned by
+  // getTypeGraph().
+  std::optional<Variable> find(std::string_view name);
+  std::vector<Variable> getVariables();
+
+  std::shared_ptr<const TypeGraph> getTypeGraph() const { return typeGraph; }
+};
+
+#endif // CEDO_BINFMT_TYPECACHE_H
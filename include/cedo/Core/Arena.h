@@ -0,0 +1,98 @@
+// Copyright 2021 Alex Brachet (alex@brachet.dev)
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CEDO_CORE_ARENA_H
+#define CEDO_CORE_ARENA_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+// Bump allocator for many small objects that all live as long as the arena.
+// Nothing is freed until the arena is destroyed, and moving the arena doesn't
+// move what it has handed out.
+class Arena {
+  static constexpr size_t slabSize = 64 * 1024;
+
+  std::vector<std::unique_ptr<char[]>> slabs;
+  char *cur = nullptr;
+  char *end = nullptr;
+  size_t bytesAllocated = 0;
+
+  void *allocateSlow(size_t size, size_t align) {
+    // Oversized allocations get a slab to themselves, the current slab is kept
+    // for later small ones.
+    bool oversized = size + align > slabSize;
+    size_t newSlabSize = oversized ? size + align : slabSize;
+    char *slab = slabs.emplace_back(new char[newSlabSize]).get();
+    bytesAllocated += newSlabSize;
+
+    void *p = slab;
+    std::align(align, size, p, newSlabSize);
+    if (!oversized) {
+      cur = static_cast<char *>(p) + size;
+      end = slab + slabSize;
+    }
+    return p;
+  }
+
+public:
+  Arena() = default;
+  Arena(Arena &&other)
+      : slabs(std::move(other.slabs)), cur(other.cur), end(other.end),
+        bytesAllocated(other.bytesAllocated) {
+    other.cur = other.end = nullptr;
+    other.bytesAllocated = 0;
+  }
+  Arena &operator=(Arena &&other) {
+    slabs = std::move(other.slabs);
+    cur = other.cur;
+    end = other.end;
+    bytesAllocated = other.bytesAllocated;
+    other.cur = other.end = nullptr;
+    other.bytesAllocated = 0;
+    return *this;
+  }
+
+  void *allocate(size_t size, size_t align) {
+    uintptr_t p = (reinterpret_cast<uintptr_t>(cur) + align - 1) & ~(align - 1);
+    if (cur && p + size <= reinterpret_cast<uintptr_t>(end)) {
+      cur = reinterpret_cast<char *>(p + size);
+      return reinterpret_cast<void *>(p);
+    }
+    return allocateSlow(size, align);
+  }
+
+  // Takes ownership of everything other has allocated.
+  void append(Arena &&other) {
+    std::move(other.slabs.begin(), other.slabs.end(),
+              std::back_inserter(slabs));
+    bytesAllocated += other.bytesAllocated;
+    other.slabs.clear();
+    other.cur = other.end = nullptr;
+    other.bytesAllocated = 0;
+  }
+
+  // Storage for num T's. Destructors are never run so T must not need one.
+  template <typename T> T *allocate(size_t num = 1) {
+    static_assert(std::is_trivially_destructible_v<T>);
+    return static_cast<T *>(allocate(sizeof(T) * num, alignof(T)));
+  }
+
+  // Total size of all slabs, including what hasn't been handed out yet.
+  size_t getBytesAllocated() const { return bytesAllocated; }
+};
+
+#endif // CEDO_CORE_ARENA_H
@@ -0,0 +1,110 @@
+// Copyright 2021 Alex Brachet (alex@brachet.dev)
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CEDO_CORE_ERROR_H
+#define CEDO_CORE_ERROR_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+// An error code with a message that's only formatted when it's asked for.
+// Many errors are only checked for and dropped, like a section or relocation
+// that isn't there, and those don't allocate.
+//
+// The message is a format where each "{}" is replaced by the next argument.
+// String arguments aren't copied, so they have to outlive the error. Errors
+// can also be made from an already formatted message, which is kept as is.
+class Error {
+public:
+  enum class Code : uint8_t {
+    Success,
+    // Something looked up, like a section, relocation or file, isn't there.
+    NotFound,
+    // The input doesn't follow its format.
+    Malformed,
+    // The input is valid but uses something cedo can't handle.
+    Unsupported,
+    // Made from a formatted message.
+    Other,
+  };
+
+  class Arg {
+    friend class Error;
+
+    enum class Kind : uint8_t { None, Number, String } kind;
+    uint64_t number;
+    std::string_view string;
+
+  public:
+    Arg() : kind(Kind::None), number(0) {}
+    template <typename T,
+              typename = std::enable_if_t<std::is_integral<T>::value>>
+    Arg(T number) : kind(Kind::Number), number(static_cast<uint64_t>(number)) {}
+    Arg(std::string_view string)
+        : kind(Kind::String), number(0), string(string) {}
+    Arg(const char *string) : Arg(std::string_view{string}) {}
+  };
+
+private:
+  Code code = Code::Success;
+  const char *format = nullptr;
+  Arg args[2];
+  std::string message;
+
+public:
+  Error() = default;
+  Error(Code code, const char *format, Arg first = {}, Arg second = {})
+      : code(code), format(format), args{first, second} {}
+  // For messages with strings that won't outlive the error.
+  Error(std::string message, Code code = Code::Other)
+      : code(code), message(std::move(message)) {}
+  Error(const char *message) : Error(std::string{message}) {}
+
+  static Error success() { return {}; }
+  static Error notFound(const char *format, Arg first = {}, Arg second = {}) {
+    return {Code::NotFound, format, first, second};
+  }
+  static Error malformed(const char *format, Arg first = {}, Arg second = {}) {
+    return {Code::Malformed, format, first, second};
+  }
+  static Error unsupported(const char *format, Arg first = {},
+                           Arg second = {}) {
+    return {Code::Unsupported, format, first, second};
+  }
+
+  // True if this is an error.
+  explicit operator bool() const { return code != Code::Success; }
+  Code getCode() const { return code; }
+
+  std::string getMessage() const {
+    if (!format)
+      return message;
+    std::string result;
+    size_t nextArg = 0;
+    for (const char *c = format; *c; c++) {
+      if (c[0] != '{' || c[1] != '}' || nextArg == 2) {
+        result += *c;
+        continue;
+      }
+      const Arg &arg = args[nextArg++];
+      if (arg.kind == Arg::Kind::Number)
+        result += std::to_string(arg.number);
+      else
+        result += arg.string;
+      c++;
+    }
+    return result;
+  }
+};
+
+#endif // CEDO_CORE_ERROR_H
@@ -16,7 +16,8 @@
 // this implementation when I've used it and don't see a reason to reinvent the
 // the wheel. Some changes have been made only to inline the dependecies. Also,
 // the llvm namespace has been removed for ErrorOr. It has also changed from
-// holding an std::error_code to std::string.
+// holding an std::error_code to an Error, which only formats its message when
+// asked for it.
 
 #ifndef CEDO_CORE_ERROROR_H
 #define CEDO_CORE_ERROROR_H
@@ -28,6 +29,8 @@
 #include <type_traits>
 #include <utility>
 
+#include "cedo/Core/Error.h"
+
 namespace llvm {
 
 namespace detail {
@@ -110,10 +113,13 @@ private:
   using const_pointer = const typename std::remove_reference<T>::type *;
 
 public:
-  ErrorOr(std::string s) : HasError(true) {
-    new (getErrorStorage()) std::string(s);
+  ErrorOr(Error E) : HasError(true) {
+    assert(E && "ErrorOr made from a successful Error");
+    new (getErrorStorage()) Error(std::move(E));
   }
 
+  ErrorOr(std::string s) : ErrorOr(Error(std::move(s))) {}
+
   template <class OtherT>
   ErrorOr(OtherT &&Val,
           typename std::enable_if<std::is_convertible<OtherT, T>::value>::type
@@ -171,9 +177,8 @@ public:
   ~ErrorOr() {
     if (!HasError)
       getStorage()->~storage_type();
-    else {
-      std::string dtor = std::move(*getErrorStorage());
-    }
+    else
+      getErrorStorage()->~Error();
   }
 
   /// Return false if there is an error.
@@ -183,9 +188,12 @@ public:
   const_reference get() const { return const_cast<ErrorOr<T> *>(this)->get(); }
 
   std::string getError() const {
-    return HasError ? *getErrorStorage() : std::string();
+    return HasError ? getErrorStorage()->getMessage() : std::string();
   }
 
+  /// The error, to pass on without formatting it. Success if there is a value.
+  Error takeError() const { return HasError ? *getErrorStorage() : Error(); }
+
   pointer operator->() { return toPointer(getStorage()); }
 
   const_pointer operator->() const { return toPointer(getStorage()); }
@@ -203,7 +211,7 @@ private:
     } else {
       // Get other's error.
       HasError = true;
-      new (getErrorStorage()) std::string(Other.getError());
+      new (getErrorStorage()) Error(*Other.getErrorStorage());
     }
   }
 
@@ -233,7 +241,7 @@ private:
     } else {
       // Get other's error.
       HasError = true;
-      new (getErrorStorage()) std::string(Other.getError());
+      new (getErrorStorage()) Error(std::move(*Other.getErrorStorage()));
     }
   }
 
@@ -263,18 +271,18 @@ private:
     return reinterpret_cast<const storage_type *>(TStorage.buffer);
   }
 
-  std::string *getErrorStorage() {
+  Error *getErrorStorage() {
     assert(HasError && "Cannot get error when a value exists!");
-    return reinterpret_cast<std::string *>(ErrorStorage.buffer);
+    return reinterpret_cast<Error *>(ErrorStorage.buffer);
   }
 
-  const std::string *getErrorStorage() const {
+  const Error *getErrorStorage() const {
     return const_cast<ErrorOr<T> *>(this)->getErrorStorage();
   }
 
   union {
     llvm::AlignedCharArrayUnion<storage_type> TStorage;
-    llvm::AlignedCharArrayUnion<std::string> ErrorStorage;
+    llvm::AlignedCharArrayUnion<Error> ErrorStorage;
   };
   bool HasError : 1;
 };
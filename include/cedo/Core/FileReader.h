@@ -20,16 +20,29 @@
 #include "ErrorOr.h"
 
 struct FileReader {
+  enum class MapMode {
+    // Every page is read in when the file is opened.
+    Populate,
+    // Pages are read in as they are touched. Users say which ranges they are
+    // about to read with willNeed and are done with with dontNeed.
+    Lazy,
+  };
+
   void *file_mapping = MAP_FAILED;
   size_t size;
+  MapMode mode;
+
+  FileReader(void *file_mapping, size_t size, MapMode mode)
+      : file_mapping(file_mapping), size(size), mode(mode) {}
 
-  FileReader(void *file_mapping, size_t size)
-      : file_mapping(file_mapping), size(size) {}
+  void advise(const void *start, size_t length, int advice) const;
 
 public:
-  static ErrorOr<FileReader> open(std::string_view path);
+  static ErrorOr<FileReader> open(std::string_view path,
+                                  MapMode mode = MapMode::Populate);
   // Needed for ErrorOr<FileReader> even though it's ugly...
-  FileReader(FileReader &&f) : file_mapping(f.file_mapping), size(f.size) {
+  FileReader(FileReader &&f)
+      : file_mapping(f.file_mapping), size(f.size), mode(f.mode) {
     f.file_mapping = MAP_FAILED;
   }
   ~FileReader();
@@ -41,6 +54,18 @@ public:
   operator const char *() const { return getFileBuffer(); }
 
   size_t getFileSize() const { return size; }
+
+  // Hints for Lazy mappings, these do nothing for Populate ones. The range is
+  // about to be read front to back.
+  void willNeed(const void *start, size_t length) const {
+    advise(start, length, MADV_SEQUENTIAL);
+    advise(start, length, MADV_WILLNEED);
+  }
+  // The range won't be read again soon, so its pages can be dropped. They are
+  // read back in from the file if it is.
+  void dontNeed(const void *start, size_t length) const {
+    advise(start, length, MADV_DONTNEED);
+  }
 };
 
 #endif // CEDO_CORE_FILEREADER_H
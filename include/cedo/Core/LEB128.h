@@ -0,0 +1,159 @@
+// Copyright 2021 Alex Brachet (alex@brachet.dev)
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CEDO_CORE_LEB128_H
+#define CEDO_CORE_LEB128_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// The fast paths read whole words past the end of the value, which is only
+// safe if they don't cross into the next page. ASan doesn't know that.
+#if defined(__SANITIZE_ADDRESS__)
+#define CEDO_LEB128_WIDE_READS 0
+#else
+#define CEDO_LEB128_WIDE_READS 1
+#endif
+
+// Decoders reading a byte at a time, which the faster ones fall back to.
+// Bits past the 64th are dropped.
+inline uint64_t readULEB128Bytewise(const uint8_t *&ptr) {
+  uint64_t result = 0;
+  unsigned shift = 0;
+  uint8_t byte;
+  do {
+    byte = *ptr++;
+    if (shift < 64)
+      result |= static_cast<uint64_t>(byte & 0x7f) << shift;
+    shift += 7;
+  } while (byte & 0x80);
+  return result;
+}
+
+inline int64_t readSLEB128Bytewise(const uint8_t *&ptr) {
+  uint64_t result = 0;
+  unsigned shift = 0;
+  uint8_t byte;
+  do {
+    byte = *ptr++;
+    if (shift < 64)
+      result |= static_cast<uint64_t>(byte & 0x7f) << shift;
+    shift += 7;
+  } while (byte & 0x80);
+  if (shift < 64 && (byte & 0x40))
+    result |= ~uint64_t{0} << shift;
+  return static_cast<int64_t>(result);
+}
+
+inline void skipLEB128sBytewise(const uint8_t *&ptr, size_t count) {
+  while (count--)
+    while (*ptr++ & 0x80)
+      ;
+}
+
+namespace leb128 {
+
+inline bool canReadWide(const uint8_t *ptr, size_t size) {
+  return CEDO_LEB128_WIDE_READS &&
+         (reinterpret_cast<uintptr_t>(ptr) & 4095) <= 4096 - size;
+}
+
+// Decodes values of at most 8 bytes from a little endian word holding them,
+// without a loop: the first byte without the high bit set ends the value, and
+// the 7 bit groups are packed together pairwise. Returns the number of bytes
+// or 0 if the value is longer.
+inline unsigned decodeWord(uint64_t word, uint64_t &value) {
+  uint64_t ends = ~word & 0x8080808080808080;
+  if (!ends)
+    return 0;
+  unsigned size = __builtin_ctzll(ends) / 8 + 1;
+  if (size < 8)
+    word &= (uint64_t{1} << (size * 8)) - 1;
+  word &= 0x7f7f7f7f7f7f7f7f;
+  word = (word & 0x007f007f007f007f) | ((word & 0x7f007f007f007f00) >> 1);
+  word = (word & 0x00003fff00003fff) | ((word & 0x3fff00003fff0000) >> 2);
+  word = (word & 0x000000000fffffff) | ((word & 0x0fffffff00000000) >> 4);
+  value = word;
+  return size;
+}
+
+} // namespace leb128
+
+inline uint64_t readULEB128(const uint8_t *&ptr) {
+  // Most values, like abbrev codes, fit in a byte.
+  if (!(*ptr & 0x80))
+    return *ptr++;
+  if (leb128::canReadWide(ptr, 8)) {
+    uint64_t word, value;
+    std::memcpy(&word, ptr, sizeof(word));
+    if (unsigned size = leb128::decodeWord(word, value)) {
+      ptr += size;
+      return value;
+    }
+  }
+  return readULEB128Bytewise(ptr);
+}
+
+inline int64_t readSLEB128(const uint8_t *&ptr) {
+  if (!(*ptr & 0x80)) {
+    // Sign extend from bit 6.
+    int64_t value = static_cast<int64_t>(uint64_t{*ptr++} << 57) >> 57;
+    return value;
+  }
+  if (leb128::canReadWide(ptr, 8)) {
+    uint64_t word, value;
+    std::memcpy(&word, ptr, sizeof(word));
+    if (unsigned size = leb128::decodeWord(word, value)) {
+      ptr += size;
+      unsigned unused = 64 - size * 7;
+      return static_cast<int64_t>(value << unused) >> unused;
+    }
+  }
+  return readSLEB128Bytewise(ptr);
+}
+
+// Both encodings end on the first byte without the high bit set.
+inline void skipLEB128(const uint8_t *&ptr) {
+  while (*ptr++ & 0x80)
+    ;
+}
+
+// Skips count consecutive values. With SSE2 this counts the bytes ending a
+// value 16 at a time.
+inline void skipLEB128s(const uint8_t *&ptr, size_t count) {
+#if defined(__SSE2__)
+  while (count > 1 && leb128::canReadWide(ptr, 16)) {
+    __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(ptr));
+    unsigned ends = ~_mm_movemask_epi8(bytes) & 0xffff;
+    size_t numEnds = __builtin_popcount(ends);
+    if (numEnds < count) {
+      ptr += 16;
+      count -= numEnds;
+      continue;
+    }
+    // Drop the ends before the last value's.
+    for (size_t i = 1; i < count; i++)
+      ends &= ends - 1;
+    ptr += __builtin_ctz(ends) + 1;
+    return;
+  }
+#endif
+  skipLEB128sBytewise(ptr, count);
+}
+
+#undef CEDO_LEB128_WIDE_READS
+
+#endif // CEDO_CORE_LEB128_H
@@ -0,0 +1,39 @@
+// Copyright 2021 Alex Brachet (alex@brachet.dev)
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CEDO_CORE_PAGEFAULTS_H
+#define CEDO_CORE_PAGEFAULTS_H
+
+#include <sys/resource.h>
+
+#include <cstddef>
+
+// Page faults taken by every thread in the process. Take the difference of two
+// of these to count the faults in between.
+struct PageFaults {
+  // Minor faults didn't need to read from disk, major faults did.
+  size_t minor = 0;
+  size_t major = 0;
+
+  static PageFaults get() {
+    struct rusage usage;
+    if (::getrusage(RUSAGE_SELF, &usage))
+      return {};
+    return {static_cast<size_t>(usage.ru_minflt),
+            static_cast<size_t>(usage.ru_majflt)};
+  }
+
+  PageFaults operator-(const PageFaults &other) const {
+    return {minor - other.minor, major - other.major};
+  }
+};
+
+#endif // CEDO_CORE_PAGEFAULTS_H
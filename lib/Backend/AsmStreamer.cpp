@@ -0,0 +1,199 @@
+// Copyright 2021 Alex Brachet (alex@brachet.dev)
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <sys/uio.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <ostream>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "cedo/Backend/AsmStreamer.h"
+
+// Shorter runs of printable bytes are left in .byte lists.
+static constexpr size_t minStringSize = 8;
+// Longer strings are split over more than one line.
+static constexpr size_t maxStringLine = 64;
+
+// Bytes which go in a string as they are.
+static bool isPlain(uint8_t c) {
+  return c >= 0x20 && c < 0x7f && c != '"' && c != '\\';
+}
+
+// Bytes which go in a string, escaped or not.
+static bool isText(uint8_t c) {
+  return (c >= 0x20 && c < 0x7f) || c == '\n' || c == '\t';
+}
+
+// Counts the plain bytes from start. With SSE2 they're looked at 16 at a time.
+static size_t countPlain(const uint8_t *start, const uint8_t *end) {
+  const uint8_t *ptr = start;
+#if defined(__SSE2__)
+  const __m128i space = _mm_set1_epi8(0x20);
+  const __m128i del = _mm_set1_epi8(0x7f);
+  const __m128i quote = _mm_set1_epi8('"');
+  const __m128i backslash = _mm_set1_epi8('\\');
+  for (; end - ptr >= 16; ptr += 16) {
+    __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(ptr));
+    // Bytes past 0x7f are negative, so they're less than a space too.
+    __m128i special = _mm_or_si128(
+        _mm_or_si128(_mm_cmplt_epi8(bytes, space), _mm_cmpeq_epi8(bytes, del)),
+        _mm_or_si128(_mm_cmpeq_epi8(bytes, quote),
+                     _mm_cmpeq_epi8(bytes, backslash)));
+    if (unsigned mask = _mm_movemask_epi8(special))
+      return ptr - start + __builtin_ctz(mask);
+  }
+#endif
+  while (ptr != end && isPlain(*ptr))
+    ptr++;
+  return ptr - start;
+}
+
+static size_t countText(const uint8_t *start, const uint8_t *end) {
+  const uint8_t *ptr = start;
+  for (;;) {
+    ptr += countPlain(ptr, end);
+    if (ptr == end || !isText(*ptr))
+      return ptr - start;
+    ptr++;
+  }
+}
+
+// Each byte's decimal string, so lists of them don't go through to_chars.
+static const struct ByteStrings {
+  char strings[256][3];
+  uint8_t sizes[256];
+
+  ByteStrings() {
+    for (unsigned i = 0; i < 256; i++)
+      sizes[i] = std::to_chars(strings[i], strings[i] + 3, i).ptr - strings[i];
+  }
+
+  std::string_view operator[](uint8_t byte) const {
+    return {strings[byte], sizes[byte]};
+  }
+} byteStrings;
+
+void AsmStreamer::writeByteList(const uint8_t *start, const uint8_t *end) {
+  for (const uint8_t *ptr = start; ptr != end; ptr++) {
+    if ((ptr - start) % valuesPerLine)
+      *this << ", ";
+    else
+      *this << Byte::directive << ' ';
+    *this << byteStrings[*ptr];
+  }
+  if (start != end)
+    *this << '\n';
+}
+
+void AsmStreamer::writeEscaped(const uint8_t *start, const uint8_t *end) {
+  for (const uint8_t *ptr = start; ptr != end; ptr++) {
+    size_t plain = countPlain(ptr, end);
+    *this << std::string_view{reinterpret_cast<const char *>(ptr), plain};
+    ptr += plain;
+    if (ptr == end)
+      break;
+    *this << '\\';
+    if (*ptr == '\n') {
+      *this << 'n';
+    } else if (*ptr == '\t') {
+      *this << 't';
+    } else if (isText(*ptr)) {
+      *this << static_cast<char>(*ptr);
+    } else {
+      // Three octal digits, so a digit after it isn't taken as part of it.
+      *this << static_cast<char>('0' + (*ptr >> 6))
+            << static_cast<char>('0' + (*ptr >> 3 & 7))
+            << static_cast<char>('0' + (*ptr & 7));
+    }
+  }
+}
+
+AsmStreamer &AsmStreamer::operator<<(const Quoted &quoted) {
+  const auto *start = reinterpret_cast<const uint8_t *>(quoted.data());
+  *this << '"';
+  writeEscaped(start, start + quoted.size());
+  return *this << '"';
+}
+
+AsmStreamer &AsmStreamer::operator<<(const RawBytes &rawBytes) {
+  const uint8_t *const end = rawBytes.start + rawBytes.size;
+  // Bytes not yet written, which go in a .byte list.
+  const uint8_t *bytes = rawBytes.start;
+  for (const uint8_t *ptr = bytes; ptr != end;) {
+    size_t textSize = countText(ptr, end);
+    if (textSize < minStringSize) {
+      ptr += textSize ? textSize : 1;
+      continue;
+    }
+
+    writeByteList(bytes, ptr);
+    const uint8_t *textEnd = ptr + textSize;
+    bool nullTerminated = textEnd != end && !*textEnd;
+    while (ptr != textEnd) {
+      size_t lineSize = std::min<size_t>(textEnd - ptr, maxStringLine);
+      bool isLast = lineSize == static_cast<size_t>(textEnd - ptr);
+      *this << Directive{isLast && nullTerminated ? ".string" : ".ascii"}
+            << " \"";
+      writeEscaped(ptr, ptr + lineSize);
+      *this << "\"\n";
+      ptr += lineSize;
+    }
+    if (nullTerminated)
+      ptr++;
+    bytes = ptr;
+  }
+  writeByteList(bytes, end);
+  return *this;
+}
+
+void AsmStreamer::writeBuffer(std::string_view extra) {
+  size_t size = current - buffer.get();
+  current = buffer.get();
+  if (failed)
+    return;
+
+  if (underlyingStream) {
+    underlyingStream->write(buffer.get(), size);
+    underlyingStream->write(extra.data(), extra.size());
+    failed = !*underlyingStream;
+    return;
+  }
+
+  // Strings too big for the buffer go out along with it rather than being
+  // copied in a piece at a time.
+  iovec iov[2] = {{buffer.get(), size},
+                  {const_cast<char *>(extra.data()), extra.size()}};
+  for (iovec *next = iov, *end = iov + 2; next != end;) {
+    if (!next->iov_len) {
+      next++;
+      continue;
+    }
+    ssize_t written = writev(fd, next, end - next);
+    if (written < 0) {
+      if (errno == EINTR)
+        continue;
+      failed = true;
+      return;
+    }
+    for (size_t left = written; left;) {
+      size_t consumed = std::min(left, next->iov_len);
+      next->iov_base = static_cast<char *>(next->iov_base) + consumed;
+      next->iov_len -= consumed;
+      left -= consumed;
+      if (!next->iov_len)
+        next++;
+    }
+  }
+}
@@ -9,7 +9,10 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <unistd.h>
+
 #include <algorithm>
+#include <cerrno>
 #include <map>
 #include <ostream>
 
@@ -20,7 +23,7 @@
 #include "cedo/Binfmt/Binfmt.h"
 
 
-static size_t findAlignment(const Sym &sym) {
+size_t findAlignment(const Sym &sym) {
   auto &[_, type, addr] = sym;
   for (uintptr_t i = 1; i < type->getObjectSize(); i++)
     if (!(reinterpret_cast<uintptr_t>(addr) % i))
@@ -64,8 +67,8 @@ void AsmEmitter::emitForSize(size_t size, const uint8_t *addr) {
   return (void) (stream << (int)*addr);
 }
 
-void AsmEmitter::emitValueForIntegralType(const Type &type, const uint8_t *addr) {
-  for (size_t remainingBytes = type.getObjectSize(); remainingBytes; ) {
+void AsmEmitter::emitValue(size_t byteSize, const uint8_t *addr) {
+  for (size_t remainingBytes = byteSize; remainingBytes; ) {
     auto pair = findLargestType(outputTriple, remainingBytes);
     auto &[size, directive] = pair;
     stream << directive << ' ';
@@ -76,13 +79,36 @@ void AsmEmitter::emitValueForIntegralType(const Type &type, const uint8_t *addr)
   }
 }
 
+void AsmEmitter::emitValues(size_t byteSize, uint64_t count,
+                            const uint8_t *addr) {
+  auto [size, directive] = findLargestType(outputTriple, byteSize);
+  // Values made of pieces of different sizes are written one at a time.
+  if (byteSize % size) {
+    for (uint64_t i = 0; i < count; i++)
+      emitValue(byteSize, addr + i * byteSize);
+    return;
+  }
+
+  uint64_t numValues = count * (byteSize / size);
+  if (size == 1)
+    return (void) (stream << AsmStreamer::RawBytes{addr, numValues});
+  for (uint64_t i = 0; i < numValues; i++, addr += size) {
+    if (i % AsmStreamer::valuesPerLine)
+      stream << ", ";
+    else
+      stream << directive << ' ';
+    emitForSize(size, addr);
+  }
+  stream << '\n';
+}
+
 static uint64_t getPointerValue(Triple inputTriple, const uint8_t *addr) {
   if (getAddrSize(inputTriple.addrSize) == 8)
     return *reinterpret_cast<const uint64_t *>(addr);
   return *reinterpret_cast<const uint32_t *>(addr);
 }
 
-void AsmEmitter::emitPointerType(const Type &type, const uint8_t *addr) {
+void AsmEmitter::emitPointer(const uint8_t *addr) {
   auto directive = findLargestType(outputTriple, getAddrSize(outputTriple.addrSize)).second;
   // TODO: currently assuming inputTriple == outputTriple...
   uint64_t ptr = getPointerValue(outputTriple, addr);
@@ -95,65 +121,104 @@ void AsmEmitter::emitPointerType(const Type &type, const uint8_t *addr) {
   stream << directive << ' ' << found->second << '\n';
 }
 
-using TypeAndOffT = std::pair<const Type &, off_t>;
+// The bytes a step spans if it has no pointers, or 0 if it has some or
+// overlaps what's before it.
+static uint64_t getPointerFreeSize(const LayoutPlan::Step &step) {
+  using Step = LayoutPlan::Step;
+  switch (step.kind) {
+  case Step::Values:
+    return step.size * step.count;
+  case Step::Padding:
+    return step.size > 0 ? step.size : 0;
+  case Step::Repeat:
+    return step.hasPointers ? 0 : step.size * step.count;
+  case Step::Pointer:
+    break;
+  }
+  return 0;
+}
 
-static std::vector<TypeAndOffT> getTypeChildren(const HasChildTypes &type) {
-  std::map<off_t, const Type &> memberAddresses;
+static const LayoutPlan::Step *getNextStep(const LayoutPlan::Step *step) {
+  return step + 1 +
+         (step->kind == LayoutPlan::Step::Repeat ? step->numSteps : 0);
+}
 
-  for (TypeAndOffT child : type) {
-    auto found = memberAddresses.find(child.second);
-    if (found == memberAddresses.end()) {
-      memberAddresses.emplace(child.second, child.first);
+void AsmEmitter::emitIncbin(const uint8_t *addr, uint64_t size) {
+  stream << AsmStreamer::Directive{".incbin"} << ' '
+         << AsmStreamer::Quoted{incbinFile->path} << ", " << incbinFile->size
+         << ", " << size << '\n';
+  incbinFile->size += size;
+  // Written straight from the object, there's nothing to copy it into.
+  while (size && !incbinFile->failed) {
+    ssize_t written = ::write(incbinFile->fd, addr,
+                              std::min<uint64_t>(size, 1 << 30));
+    if (written < 0 && errno == EINTR)
       continue;
+    if (written <= 0) {
+      incbinFile->failed = true;
+      break;
     }
-    if (found->second.getObjectSize() < child.first.getObjectSize()) {
-      memberAddresses.erase(child.second);
-      memberAddresses.emplace(child.second, child.first);
-    }
+    addr += written;
+    size -= written;
   }
-
-  std::vector<TypeAndOffT> ret;
-  std::transform(memberAddresses.begin(), memberAddresses.end(),
-                 std::back_insert_iterator(ret), [](auto pair) -> TypeAndOffT {
-                   return {pair.second, pair.first};
-                 });
-  return ret;
 }
 
-void AsmEmitter::emitTypeWithChildren(const Type &type, const uint8_t *addr) {
-  const HasChildTypes *iterable = dynamic_cast<const HasChildTypes *>(&type);
-  assert(iterable && "Object did not have children...");
-
-  std::vector<TypeAndOffT> children = getTypeChildren(*iterable);
-
-  size_t previousSize = 0;
-  const uint8_t *previousAddr = addr;
-
-  auto emitPaddingIfNecessary = [&] (size_t nextOffset) {
-    const uint8_t *nextMemberAddr = addr + nextOffset;
-    if (const uint8_t *prevEndAddr = previousAddr + previousSize; prevEndAddr != nextMemberAddr)
-      stream << AsmStreamer::Directive{".zero"} << ' ' << (off_t) (nextMemberAddr - prevEndAddr) << '\n';
-  };
+void AsmEmitter::emitSteps(const LayoutPlan::Step *step,
+                           const LayoutPlan::Step *end, const uint8_t *addr,
+                           bool findIncbin) {
+  using Step = LayoutPlan::Step;
+  // Steps before this are part of a run too small for incbinFile.
+  const Step *textEnd = step;
+  for (; step != end; step++) {
+    const uint8_t *stepAddr = addr + step->offset;
+    if (findIncbin && step >= textEnd) {
+      const Step *runEnd = step;
+      uint64_t runSize = 0;
+      for (; runEnd != end; runEnd = getNextStep(runEnd)) {
+        uint64_t size = getPointerFreeSize(*runEnd);
+        if (!size)
+          break;
+        runSize = runEnd->offset + size - step->offset;
+      }
+      if (runSize && runSize >= incbinFile->threshold) {
+        emitIncbin(stepAddr, runSize);
+        step = runEnd - 1;
+        continue;
+      }
+      textEnd = runEnd;
+    }
 
-  for (const TypeAndOffT &child : children) {
-    emitPaddingIfNecessary(child.second);
-    emitObject(child.first, addr + child.second);
-    previousSize = child.first.getObjectSize();
-    previousAddr = addr + child.second;
+    switch (step->kind) {
+    case Step::Values:
+      emitValues(step->size, step->count, stepAddr);
+      break;
+    case Step::Pointer:
+      emitPointer(stepAddr);
+      break;
+    case Step::Padding:
+      stream << AsmStreamer::Directive{".zero"} << ' ' << step->size << '\n';
+      break;
+    case Step::Repeat: {
+      const Step *body = step + 1;
+      const Step *bodyEnd = body + step->numSteps;
+      // Runs in the body of a Repeat without pointers are smaller than it.
+      bool findInBody = findIncbin && step->hasPointers;
+      for (uint64_t i = 0; i < step->count; i++)
+        emitSteps(body, bodyEnd, stepAddr + i * step->size, findInBody);
+      step = bodyEnd - 1;
+      break;
+    }
+    }
   }
-
-  emitPaddingIfNecessary(type.getObjectSize());
 }
 
 void AsmEmitter::emitObject(const Type &type, const uint8_t *addr) {
-  if (type.isPointer())
-    emitPointerType(type, addr);
-  else if (type.isCompound() || type.isArray())
-    emitTypeWithChildren(type, addr);
-  else if (type.isBuiltin())
-    emitValueForIntegralType(type, addr);
-  else
-    assert(false && "Can't emit type currently");
+  auto [it, inserted] = layoutPlans.try_emplace(&type);
+  if (inserted)
+    it->second = LayoutPlan::compile(type);
+  const std::vector<LayoutPlan::Step> &steps = it->second.steps;
+  emitSteps(steps.data(), steps.data() + steps.size(), addr,
+            incbinFile.has_value());
 }
 
 void AsmEmitter::emitOneSym(const Sym &sym) {
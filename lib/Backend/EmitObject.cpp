@@ -0,0 +1,302 @@
+// Copyright 2021 Alex Brachet (alex@brachet.dev)
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <elf.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+#include <ostream>
+#include <string>
+
+#include "cedo/Backend/EmitObject.h"
+
+namespace {
+
+template <AddressSize addrSize> struct ELFTypes;
+
+template <> struct ELFTypes<AddressSize::Eight> {
+  using Ehdr = Elf64_Ehdr;
+  using Shdr = Elf64_Shdr;
+  using Sym = Elf64_Sym;
+  using Rel = Elf64_Rela;
+
+  static constexpr unsigned char elfClass = ELFCLASS64;
+  static constexpr uint16_t machine = EM_X86_64;
+  static constexpr uint32_t relSectionType = SHT_RELA;
+  static constexpr std::string_view relSectionName = ".rela.data";
+
+  static Rel makeRel(uint64_t offset, uint32_t symIndex) {
+    Rel rel{};
+    rel.r_offset = offset;
+    rel.r_info = ELF64_R_INFO(symIndex, R_X86_64_64);
+    return rel;
+  }
+};
+
+template <> struct ELFTypes<AddressSize::Four> {
+  using Ehdr = Elf32_Ehdr;
+  using Shdr = Elf32_Shdr;
+  using Sym = Elf32_Sym;
+  // The addend is the pointer slot's contents, which is left as 0.
+  using Rel = Elf32_Rel;
+
+  static constexpr unsigned char elfClass = ELFCLASS32;
+  static constexpr uint16_t machine = EM_386;
+  static constexpr uint32_t relSectionType = SHT_REL;
+  static constexpr std::string_view relSectionName = ".rel.data";
+
+  static Rel makeRel(uint64_t offset, uint32_t symIndex) {
+    Rel rel{};
+    rel.r_offset = offset;
+    rel.r_info = ELF32_R_INFO(symIndex, R_386_32);
+    return rel;
+  }
+};
+
+} // namespace
+
+static uint64_t alignTo(uint64_t value, uint64_t align) {
+  return (value + align - 1) / align * align;
+}
+
+static uint64_t getSymbolSize(Triple outputTriple, const Type &type) {
+  return type.isPointer() ? getAddrSize(outputTriple.addrSize)
+                          : type.getObjectSize();
+}
+
+void ObjectEmitter::addSteps(const LayoutPlan::Step *step,
+                             const LayoutPlan::Step *end, const uint8_t *addr,
+                             uint64_t offset) {
+  using Step = LayoutPlan::Step;
+  for (; step != end; step++) {
+    const uint8_t *stepAddr = addr + step->offset;
+    uint64_t stepOffset = offset + step->offset;
+    switch (step->kind) {
+    case Step::Values:
+      std::memcpy(data.data() + stepOffset, stepAddr, step->size * step->count);
+      break;
+    case Step::Pointer: {
+      // TODO: currently assuming inputTriple == outputTriple...
+      uint64_t ptr = getAddrSize(outputTriple.addrSize) == 8
+                         ? *reinterpret_cast<const uint64_t *>(stepAddr)
+                         : *reinterpret_cast<const uint32_t *>(stepAddr);
+      if (!ptr)
+        break;
+      auto found = symIndices.find(ptr);
+      assert(found != symIndices.end() &&
+             "Can only emit pointers to output symbols");
+      relocs.push_back({stepOffset, found->second});
+      break;
+    }
+    case Step::Padding:
+      break;
+    case Step::Repeat: {
+      const Step *body = step + 1;
+      const Step *bodyEnd = body + step->numSteps;
+      for (uint64_t i = 0; i < step->count; i++)
+        addSteps(body, bodyEnd, stepAddr + i * step->size,
+                 stepOffset + i * step->size);
+      step = bodyEnd - 1;
+      break;
+    }
+    }
+  }
+}
+
+void ObjectEmitter::addObject(const Type &type, const uint8_t *addr,
+                              uint64_t offset) {
+  auto [it, inserted] = layoutPlans.try_emplace(&type);
+  if (inserted)
+    it->second = LayoutPlan::compile(type);
+  const std::vector<LayoutPlan::Step> &steps = it->second.steps;
+  addSteps(steps.data(), steps.data() + steps.size(), addr, offset);
+}
+
+void ObjectEmitter::write(const void *bytes, size_t size) {
+  if (failed)
+    return;
+  const char *current = static_cast<const char *>(bytes);
+  if (underlyingStream) {
+    failed = !underlyingStream->write(current, size);
+    return;
+  }
+  while (size) {
+    ssize_t written = ::write(fd, current, size);
+    if (written < 0 && errno == EINTR)
+      continue;
+    if (written <= 0) {
+      failed = true;
+      return;
+    }
+    current += written;
+    size -= written;
+  }
+}
+
+void ObjectEmitter::writeZeros(size_t size) {
+  static constexpr char zeros[16] = {};
+  for (; size > sizeof(zeros); size -= sizeof(zeros))
+    write(zeros, sizeof(zeros));
+  write(zeros, size);
+}
+
+template <typename ELFT>
+void ObjectEmitter::writeFile(const std::vector<Sym> &symList,
+                              const std::vector<uint64_t> &symOffsets,
+                              std::string_view versionStr) {
+  using Ehdr = typename ELFT::Ehdr;
+  using Shdr = typename ELFT::Shdr;
+  using ELFSym = typename ELFT::Sym;
+  using Rel = typename ELFT::Rel;
+
+  constexpr uint16_t dataIndex = 1;
+  uint64_t dataAlign = 1;
+  std::string strtab(1, '\0');
+  std::vector<ELFSym> syms(symList.size() + 1);
+  for (size_t i = 0; i < symList.size(); i++) {
+    auto &[name, type, _] = symList[i];
+    ELFSym &sym = syms[i + 1];
+    sym.st_name = strtab.size();
+    strtab.append(name).push_back('\0');
+    sym.st_value = symOffsets[i];
+    sym.st_size = getSymbolSize(outputTriple, *type);
+    // The same for both classes.
+    sym.st_info = ELF64_ST_INFO(STB_GLOBAL, STT_OBJECT);
+    sym.st_shndx = dataIndex;
+    dataAlign = std::max<uint64_t>(dataAlign, findAlignment(symList[i]));
+  }
+
+  std::vector<Rel> rels;
+  rels.reserve(relocs.size());
+  for (const Reloc &reloc : relocs)
+    rels.push_back(ELFT::makeRel(reloc.offset, reloc.symIndex));
+
+  // Like .ident, which starts .comment with a null byte.
+  std::string comment(1, '\0');
+  comment += "cedo";
+  if (versionStr.size())
+    comment.append(1, ' ').append(versionStr);
+  comment.push_back('\0');
+
+  // Sections are laid out in the order they're added, after the header.
+  std::string shstrtab(1, '\0');
+  std::vector<Shdr> shdrs(1);
+  std::vector<const void *> contents(1);
+  uint64_t fileOffset = sizeof(Ehdr);
+  auto addSection = [&](std::string_view name, uint32_t type, uint64_t flags,
+                        const void *bytes, uint64_t size, uint64_t align) {
+    Shdr &shdr = shdrs.emplace_back();
+    shdr.sh_name = shstrtab.size();
+    shstrtab.append(name).push_back('\0');
+    shdr.sh_type = type;
+    shdr.sh_flags = flags;
+    shdr.sh_offset = fileOffset = alignTo(fileOffset, align);
+    shdr.sh_size = size;
+    shdr.sh_addralign = align;
+    fileOffset += size;
+    contents.push_back(bytes);
+    return static_cast<uint32_t>(shdrs.size() - 1);
+  };
+
+  addSection(".data", SHT_PROGBITS, SHF_ALLOC | SHF_WRITE, data.data(),
+             data.size(), dataAlign);
+  uint32_t relIndex = 0;
+  if (rels.size())
+    relIndex = addSection(ELFT::relSectionName, ELFT::relSectionType,
+                          SHF_INFO_LINK, rels.data(), rels.size() * sizeof(Rel),
+                          alignof(Rel));
+  uint32_t commentIndex = addSection(".comment", SHT_PROGBITS,
+                                     SHF_MERGE | SHF_STRINGS, comment.data(),
+                                     comment.size(), 1);
+  // Without it linkers assume the stack needs to be executable.
+  addSection(".note.GNU-stack", SHT_PROGBITS, 0, nullptr, 0, 1);
+  uint32_t symtabIndex =
+      addSection(".symtab", SHT_SYMTAB, 0, syms.data(),
+                 syms.size() * sizeof(ELFSym), alignof(ELFSym));
+  uint32_t strtabIndex = addSection(".strtab", SHT_STRTAB, 0, strtab.data(),
+                                    strtab.size(), 1);
+  uint32_t shstrtabIndex =
+      addSection(".shstrtab", SHT_STRTAB, 0, nullptr, 0, 1);
+  // Its own name was only just added.
+  shdrs[shstrtabIndex].sh_size = shstrtab.size();
+  contents[shstrtabIndex] = shstrtab.data();
+  fileOffset += shstrtab.size();
+
+  if (relIndex) {
+    shdrs[relIndex].sh_link = symtabIndex;
+    shdrs[relIndex].sh_info = dataIndex;
+    shdrs[relIndex].sh_entsize = sizeof(Rel);
+  }
+  shdrs[commentIndex].sh_entsize = 1;
+  shdrs[symtabIndex].sh_link = strtabIndex;
+  // Index of the first global symbol.
+  shdrs[symtabIndex].sh_info = 1;
+  shdrs[symtabIndex].sh_entsize = sizeof(ELFSym);
+
+  Ehdr ehdr{};
+  std::memcpy(ehdr.e_ident, ELFMAG, SELFMAG);
+  ehdr.e_ident[EI_CLASS] = ELFT::elfClass;
+  ehdr.e_ident[EI_DATA] = ELFDATA2LSB;
+  ehdr.e_ident[EI_VERSION] = EV_CURRENT;
+  ehdr.e_ident[EI_OSABI] = ELFOSABI_SYSV;
+  ehdr.e_type = ET_REL;
+  ehdr.e_machine = ELFT::machine;
+  ehdr.e_version = EV_CURRENT;
+  ehdr.e_shoff = alignTo(fileOffset, alignof(Shdr));
+  ehdr.e_ehsize = sizeof(Ehdr);
+  ehdr.e_shentsize = sizeof(Shdr);
+  ehdr.e_shnum = shdrs.size();
+  ehdr.e_shstrndx = shstrtabIndex;
+
+  write(&ehdr, sizeof(ehdr));
+  uint64_t written = sizeof(ehdr);
+  for (size_t i = 1; i < shdrs.size(); i++) {
+    writeZeros(shdrs[i].sh_offset - written);
+    write(contents[i], shdrs[i].sh_size);
+    written = shdrs[i].sh_offset + shdrs[i].sh_size;
+  }
+  writeZeros(ehdr.e_shoff - written);
+  write(shdrs.data(), shdrs.size() * sizeof(Shdr));
+}
+
+Error ObjectEmitter::emitObjectFile(const std::vector<Sym> &symList,
+                                    std::string_view versionStr) {
+  if (outputTriple.endianness != Endianness::Little)
+    return Error::unsupported("Can't write big endian objects");
+
+  // Symbols are aligned like .align would, one after the other.
+  std::vector<uint64_t> symOffsets;
+  uint64_t end = 0;
+  for (size_t i = 0; i < symList.size(); i++) {
+    auto &[_, type, addr] = symList[i];
+    uint64_t align = std::max<uint64_t>(findAlignment(symList[i]), 1);
+    uint64_t offset = alignTo(end, align);
+    symOffsets.push_back(offset);
+    end = offset + getSymbolSize(outputTriple, *type);
+    symIndices[reinterpret_cast<uint64_t>(addr)] = i + 1;
+  }
+
+  data.assign(end, 0);
+  relocs.clear();
+  for (size_t i = 0; i < symList.size(); i++) {
+    auto &[_, type, addr] = symList[i];
+    addObject(*type, static_cast<const uint8_t *>(addr), symOffsets[i]);
+  }
+
+  if (outputTriple.addrSize == AddressSize::Eight)
+    writeFile<ELFTypes<AddressSize::Eight>>(symList, symOffsets, versionStr);
+  else
+    writeFile<ELFTypes<AddressSize::Four>>(symList, symOffsets, versionStr);
+  return Error::success();
+}
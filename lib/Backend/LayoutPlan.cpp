@@ -0,0 +1,140 @@
+// Copyright 2021 Alex Brachet (alex@brachet.dev)
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+
+#include "cedo/Backend/LayoutPlan.h"
+
+namespace {
+
+using Step = LayoutPlan::Step;
+
+class PlanCompiler {
+  std::vector<Step> &steps;
+  // Steps before this one belong to a Repeat that's done, or to the one whose
+  // body is being compiled. Values can't be merged into them.
+  size_t mergeFloor = 0;
+
+  void addValues(uint64_t offset, uint64_t size, uint64_t count) {
+    if (steps.size() > mergeFloor) {
+      Step &last = steps.back();
+      if (last.kind == Step::Values &&
+          static_cast<uint64_t>(last.size) == size &&
+          last.offset + last.count * size == offset) {
+        last.count += count;
+        return;
+      }
+    }
+    steps.push_back(
+        {Step::Values, false, 0, offset, static_cast<int64_t>(size), count});
+  }
+
+  void addPadding(uint64_t offset, int64_t size) {
+    steps.push_back({Step::Padding, false, 0, offset, size, 1});
+  }
+
+  void addStruct(const StructType &type, uint64_t offset);
+  void addArray(const ArrayType &type, uint64_t offset);
+
+public:
+  PlanCompiler(std::vector<Step> &steps) : steps(steps) {}
+
+  void add(const Type &type, uint64_t offset);
+};
+
+} // namespace
+
+void PlanCompiler::addStruct(const StructType &type, uint64_t offset) {
+  std::vector<StructType::Member> members = type.members;
+  std::stable_sort(
+      members.begin(), members.end(),
+      [](const StructType::Member &a, const StructType::Member &b) {
+        return a.second < b.second;
+      });
+
+  uint64_t end = offset;
+  for (auto it = members.begin(); it != members.end();) {
+    // Members at the same offset, like those of a union, are emitted as the
+    // first of the largest of them.
+    auto largest = it;
+    for (it++; it != members.end() && it->second == largest->second; it++)
+      if (it->first->getObjectSize() > largest->first->getObjectSize())
+        largest = it;
+
+    uint64_t memberOffset = offset + largest->second;
+    if (memberOffset != end)
+      addPadding(end, static_cast<int64_t>(memberOffset - end));
+    add(*largest->first, memberOffset);
+    end = memberOffset + largest->first->getObjectSize();
+  }
+
+  if (uint64_t typeEnd = offset + type.getObjectSize(); typeEnd != end)
+    addPadding(end, static_cast<int64_t>(typeEnd - end));
+}
+
+void PlanCompiler::addArray(const ArrayType &type, uint64_t offset) {
+  const Type &element = *type.elementType;
+  uint64_t elementSize = element.getObjectSize();
+  // Elements without a size all start at the same offset, only one of them is
+  // emitted.
+  uint64_t count = elementSize ? type.numElements
+                               : std::min<uint64_t>(type.numElements, 1);
+  if (!count)
+    return;
+  if (count == 1)
+    return add(element, offset);
+
+  size_t outerFloor = mergeFloor;
+  size_t repeat = steps.size();
+  steps.push_back({Step::Repeat, false, 0, offset,
+                   static_cast<int64_t>(elementSize), count});
+  mergeFloor = steps.size();
+  add(element, 0);
+
+  size_t numSteps = steps.size() - repeat - 1;
+  const Step &first = steps.back();
+  // Elements which are a single run of values make a longer run.
+  if (numSteps == 1 && first.kind == Step::Values && !first.offset &&
+      first.count * first.size == elementSize) {
+    uint64_t size = first.size, numValues = first.count;
+    steps.resize(repeat);
+    mergeFloor = outerFloor;
+    return addValues(offset, size, numValues * count);
+  }
+  if (!numSteps) {
+    steps.pop_back();
+    mergeFloor = outerFloor;
+    return;
+  }
+  steps[repeat].numSteps = static_cast<uint32_t>(numSteps);
+  steps[repeat].hasPointers =
+      std::any_of(steps.begin() + repeat + 1, steps.end(),
+                  [](const Step &step) { return step.kind == Step::Pointer; });
+  mergeFloor = steps.size();
+}
+
+void PlanCompiler::add(const Type &type, uint64_t offset) {
+  if (type.isPointer())
+    steps.push_back({Step::Pointer, false, 0, offset,
+                     static_cast<int64_t>(type.getObjectSize()), 1});
+  else if (type.isCompound())
+    addStruct(static_cast<const StructType &>(type), offset);
+  else if (type.isArray())
+    addArray(static_cast<const ArrayType &>(type), offset);
+  else if (uint64_t size = type.getObjectSize())
+    addValues(offset, size, 1);
+}
+
+LayoutPlan LayoutPlan::compile(const Type &type) {
+  LayoutPlan plan;
+  PlanCompiler(plan.steps).add(type, 0);
+  return plan;
+}
@@ -10,303 +10,1630 @@
 // limitations under the License.
 
 #include <algorithm>
+#include <atomic>
 #include <cstring>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <stack>
 #include <string>
+#include <thread>
+#include <unordered_map>
 
 #include "cedo/Binfmt/Binfmt.h"
 #include "cedo/Binfmt/DWARF.h"
 #include "cedo/Binfmt/DWARFConstants.h"
 #include "cedo/Core/EndianByteReader.h"
 #include "cedo/Core/ErrorOr.h"
+#include "cedo/Core/LEB128.h"
 
+#include "DWARFNameIndex.h"
+#include "DWARFPackage.h"
 #include "ELF.h"
 
 using namespace std::string_literals;
 
+// Unit types from DWARF 5 unit headers.
+static constexpr uint8_t DW_UT_compile = 0x01;
+static constexpr uint8_t DW_UT_type = 0x02;
+static constexpr uint8_t DW_UT_partial = 0x03;
+static constexpr uint8_t DW_UT_skeleton = 0x04;
+static constexpr uint8_t DW_UT_split_compile = 0x05;
+static constexpr uint8_t DW_UT_split_type = 0x06;
+
+static bool isStringIndexForm(DW_FORM form) {
+  return form == DW_FORM_strx || form == DW_FORM_strx1 ||
+         form == DW_FORM_strx2 || form == DW_FORM_strx3 ||
+         form == DW_FORM_strx4 || form == DW_FORM_GNU_str_index;
+}
+
+// A file with the DWARF dwz moved out of several objects, which
+// DW_FORM_GNU_ref_alt and DW_FORM_GNU_strp_alt, or DWARF 5's sup forms, refer
+// into. It's mapped once. Its strings are read in place and its DIEs the first
+// time a reference reaches one, with offsets from offsetBase on so they don't
+// overlap the object's own.
+class SupplementaryFile {
+  std::shared_ptr<const ObjectFileReader> file;
+  const ELF::Reader &reader;
+  const DWARF::ParseMode mode;
+  const uint64_t offsetBase;
+  const ELF::Section abbrevSec;
+  const ELF::Section debugInfo;
+  const ELF::Section str;
+  std::once_flag once;
+  std::unique_ptr<DWARF> dwarf;
+
+public:
+  SupplementaryFile(std::shared_ptr<const ObjectFileReader> file,
+                    const ELF::Reader &reader, DWARF::ParseMode mode,
+                    uint64_t offsetBase)
+      : file(std::move(file)), reader(reader), mode(mode),
+        offsetBase(offsetBase), abbrevSec(reader.getSection(".debug_abbrev")),
+        debugInfo(reader.getSection(".debug_info")),
+        str(reader.getSection(".debug_str")) {}
+
+  static ErrorOr<std::shared_ptr<SupplementaryFile>>
+  open(const ELF::Reader &elfReader, DWARF::ParseMode mode,
+       uint64_t offsetBase, const DebugFileOptions &options) {
+    ErrorOr<std::unique_ptr<ObjectFileReader>> fileOrErr =
+        openSupplementaryFile(elfReader, options);
+    if (!fileOrErr)
+      return fileOrErr.takeError();
+    if (!*fileOrErr)
+      return Error::notFound("Debug info refers to a supplementary file but "
+                             "the object doesn't name one");
+    std::shared_ptr<const ObjectFileReader> file = std::move(*fileOrErr);
+    const auto *supReader = dynamic_cast<const ELF::Reader *>(file.get());
+    if (!supReader)
+      return Error::unsupported("Supplementary debug file isn't an ELF file");
+    return std::make_shared<SupplementaryFile>(std::move(file), *supReader,
+                                               mode, offsetBase);
+  }
+
+  uint64_t getOffsetBase() const { return offsetBase; }
+  // Offsets from here on are free for other DIEs.
+  uint64_t getEndOffset() const { return offsetBase + debugInfo.size; }
+
+  uint64_t resolveString(uint64_t offset) const {
+    return offset < str.size ? reinterpret_cast<uintptr_t>(str.data + offset)
+                             : 0;
+  }
+
+  const DWARF::DIE *findDIEFromOffset(uint64_t offset);
+};
+
 class DWARFReader {
+  friend class SupplementaryFile;
+  friend class TypeUnits;
+
+  // An attribute specification with the size of its form resolved for the
+  // units that use it.
+  struct AttributeSpec {
+    DW_AT attr;
+    DW_FORM form;
+    // Byte size of the value, or variableSize if it has to be decoded to know.
+    uint8_t size;
+    bool isString;
+    // DW_FORM_strx* and DW_FORM_GNU_str_index, resolved through
+    // .debug_str_offsets.
+    bool isStringIndex;
+    // References relative to the unit, which get rebased onto .debug_info.
+    bool isUnitRef;
+    // DW_FORM_ref_sig8 references to type units.
+    bool isSignature;
+    // References to DIEs and strings in the supplementary file.
+    bool isSupRef;
+    bool isSupString;
+    // The value of forms which take no space in the DIE, from
+    // DW_FORM_implicit_const or 1 for DW_FORM_flag_present.
+    uint64_t implicitValue;
+
+    static constexpr uint8_t variableSize = 0xff;
+  };
+
+  // How DIEs are skipped over: fixedSize bytes, then numLEB128s LEB128
+  // values, then the attribute at index if it isn't noAttribute.
+  struct SkipStep {
+    uint32_t fixedSize = 0;
+    uint16_t numLEB128s = 0;
+    uint16_t index = noAttribute;
+
+    static constexpr uint16_t noAttribute = UINT16_MAX;
+  };
+
   struct Abbrev {
     DW_TAG tag;
     bool children;
-    std::vector<std::pair<DW_AT, DW_FORM>> attributes;
+    bool hasSibling;
+    std::vector<AttributeSpec> attributes;
+    // Set when all attributes have a fixed size, DIEs using this abbrev are
+    // then decoded without any size checks and skipped in one step.
+    std::optional<size_t> fixedSize;
+    // Runs of fixed size and LEB128 attributes are skipped together.
+    std::vector<SkipStep> skipSteps;
+  };
+
+  class AbbrevTable {
+    std::vector<Abbrev> abbrevs;
+    // Producers number abbrevs 1, 2, 3... so they can be looked up by index,
+    // this is only used if a table doesn't.
+    std::unordered_map<uint64_t, size_t> sparseCodes;
+
+  public:
+    // Set if any attribute refers into the supplementary file.
+    bool usesSupplementaryFile = false;
+
+    Abbrev &add(uint64_t code) {
+      if (sparseCodes.empty() && code == abbrevs.size() + 1)
+        return abbrevs.emplace_back();
+      if (sparseCodes.empty())
+        for (size_t i = 0; i < abbrevs.size(); i++)
+          sparseCodes.emplace(i + 1, i);
+      sparseCodes[code] = abbrevs.size();
+      return abbrevs.emplace_back();
+    }
+
+    const Abbrev *find(uint64_t code) const {
+      if (sparseCodes.empty())
+        return code && code <= abbrevs.size() ? &abbrevs[code - 1] : nullptr;
+      auto it = sparseCodes.find(code);
+      return it == sparseCodes.end() ? nullptr : &abbrevs[it->second];
+    }
+  };
+
+  // Abbrev tables by their .debug_abbrev offset and the offset size of the
+  // units using them, which form sizes depend on. Units commonly share tables.
+  using AbbrevCache = std::map<std::pair<uint64_t, AddressSize>, AbbrevTable>;
+
+  struct UnitHeader {
+    const uint8_t *start;
+    const uint8_t *end;
+    const uint8_t *firstDIE;
+    uint16_t version;
+    uint8_t unitType;
+    AddressSize offsetSize;
+    uint64_t abbrevOffset;
+    const AbbrevTable *abbrevTable;
+    // From DWARF 5 skeleton and split unit headers.
+    uint64_t dwoID;
+    // From type unit headers, the type DIE's offset is relative to the unit.
+    uint64_t signature;
+    uint64_t typeOffset;
+    // Where the unit's entries in .debug_str_offsets start. This comes from
+    // DW_AT_str_offsets_base when it's not set here.
+    std::optional<uint64_t> strOffsetsBase;
+  };
+
+  // A section looked up the first time it's needed by any of the threads
+  // reading units.
+  class LazySection {
+    const ELF::Reader &reader;
+    const char *name;
+    std::once_flag once;
+    ELF::Section section;
+
+  public:
+    LazySection(const ELF::Reader &reader, const char *name)
+        : reader(reader), name(name) {}
+
+    ELF::Section get() {
+      std::call_once(once, [this] { section = reader.getSection(name); });
+      return section;
+    }
+  };
+
+  // DW_FORM_strp attributes index into str, DW_FORM_line_strp into lineStr and
+  // DW_FORM_strx into str through strOffsets. Strings in relocatable objects
+  // come from relocations, so these are never looked up for them.
+  struct StringSections {
+    LazySection str;
+    LazySection strOffsets;
+    LazySection lineStr;
+
+    StringSections(const ELF::Reader &reader, bool dwo)
+        : str(reader, dwo ? ".debug_str.dwo" : ".debug_str"),
+          strOffsets(reader,
+                     dwo ? ".debug_str_offsets.dwo" : ".debug_str_offsets"),
+          lineStr(reader, ".debug_line_str") {}
+  };
+
+  // Where a skeleton unit's split unit is, in a .dwo or a .dwp package.
+  struct SplitUnit {
+    std::string_view dwoName;
+    std::string_view compDir;
+    uint64_t dwoID;
+    // The package or .dwo the unit was found in. dwoFile owns a .dwo, the
+    // package is owned by readSplitUnits.
+    const ELF::Reader *reader = nullptr;
+    std::shared_ptr<const ObjectFileReader> dwoFile;
+    DWARFPackage::UnitContribution contribution;
   };
 
   DWARF &dwarf;
+  const DWARF::ParseMode mode;
   const ELF::Reader &elfReader;
   Triple objTriple;
 
-  const char *const objectFileStart;
-  const uint8_t *const abbrevSecStart;
+  // The section the units are in, relocations are looked up in it.
+  const ELF::Section debugInfoSec;
   const uint8_t *const debugInfoStart;
+  // DW_AT_sibling and other references are relative to the unit.
+  const uint8_t *unitStart;
+  const UnitHeader *unitHeader;
+  StringSections &strings;
+  SupplementaryFile *supFile = nullptr;
+  // Found on the unit's first DW_FORM_strx.
+  std::optional<uint64_t> strOffsetsBase;
+  // Split units each start their own section at 0, so their DIE offsets are
+  // moved past those of earlier units to keep them unique and in order.
+  const uint64_t offsetBase;
   AddressSize currentSecAddrSize;
-  std::vector<Abbrev> abbrevTable;
+  const AbbrevTable *abbrevTable;
+
+  struct ParentDIE {
+    // Indices into dwarf.debugInfo, lastChild is 0 until the first child is
+    // read.
+    size_t index;
+    size_t lastChild = 0;
 
-  std::stack<uint64_t> parentDIEs;
+    ParentDIE(size_t index) : index(index) {}
+  };
+  std::stack<ParentDIE> parentDIEs;
+  // Qualified name prefix ("ns::S::") for the children of each DIE in
+  // parentDIEs.
+  std::stack<std::string> scopePrefixes;
+  // Qualified names of variable declarations, for definitions that refer back
+  // to them through DW_AT_specification.
+  std::unordered_map<uint64_t, std::string> declarationNames;
 
-  DWARFReader(DWARF &dwarf, const ELF::Reader &elfReader,
-              const char *objectFileStart, const uint8_t *abbrevSecStart,
-              const uint8_t *debugInfoStart)
-      : dwarf(dwarf), elfReader(elfReader), objTriple(elfReader.getTriple()),
-        objectFileStart(objectFileStart), abbrevSecStart(abbrevSecStart),
-        debugInfoStart(debugInfoStart) {}
+  DWARFReader(DWARF &dwarf, DWARF::ParseMode mode,
+              const ELF::Reader &elfReader, ELF::Section debugInfo,
+              StringSections &strings, uint64_t offsetBase = 0)
+      : dwarf(dwarf), mode(mode), elfReader(elfReader),
+        objTriple(elfReader.getTriple()), debugInfoSec(debugInfo),
+        debugInfoStart(debugInfo.data), strings(strings),
+        offsetBase(offsetBase) {}
 
-  std::string readAbbrevTable();
-  std::string readDebugInfo();
-  std::string readOneDIE(const uint8_t *&debugInfo, const uint8_t *end);
+  static Error readAbbrevTable(ELF::Section abbrevSec, uint64_t offset,
+                               AddressSize offsetSize, AddressSize addrSize,
+                               AbbrevTable &table);
+  // Units in .debug_types are all type units, which DWARF 4 headers don't
+  // otherwise say.
+  static Error readUnitHeader(ELF::Section debugInfo, ELF::Section abbrevSec,
+                              const ELF::Reader &elfReader,
+                              const uint8_t *unit, UnitHeader &header,
+                              bool isTypesSection = false);
+  static bool isTypeUnit(const UnitHeader &header) {
+    return header.unitType == DW_UT_type ||
+           header.unitType == DW_UT_split_type;
+  }
+  // Reads the headers of the units at unitOffsets, or of every compile unit if
+  // it's null.
+  static ErrorOr<std::vector<UnitHeader>>
+  readUnitHeaders(ELF::Section debugInfo, ELF::Section abbrevSec,
+                  const ELF::Reader &elfReader,
+                  const std::vector<uint64_t> *unitOffsets);
+  // Reads an offset into section from attr on the unit's DIE.
+  std::optional<uint64_t> findUnitSectionOffset(const UnitHeader &header,
+                                                DW_AT attr,
+                                                ELF::Section section);
+  Error readUnit(const UnitHeader &header);
+  Error readOneDIE(const uint8_t *&debugInfo, const uint8_t *end);
+  Error skipDIE(const Abbrev &abbrev, const uint8_t *&debugInfo,
+                const uint8_t *end);
+  uint64_t skipAttributes(const Abbrev &abbrev, const uint8_t *&debugInfo);
+  static void setSkipSteps(Abbrev &abbrev);
+  void indexVariable(size_t dieIndex);
 
-  size_t getDTypeSize(DWARFType type, const uint8_t *ptr) {
-    if (size_t size = static_cast<uint64_t>(type); size <= 8)
+  static std::optional<size_t> getFixedSize(DWARFType type,
+                                            AddressSize offsetSize,
+                                            AddressSize addrSize) {
+    if (size_t size = static_cast<uint64_t>(type); size <= 16)
       return size;
 
     switch (type) {
     case DWARFType::DWARFAddr:
     case DWARFType::StringPtr:
-      return currentSecAddrSize == AddressSize::Eight ? 8 : 4;
-
+    case DWARFType::LineStringPtr:
+      return offsetSize == AddressSize::Eight ? 8 : 4;
     case DWARFType::MachineAddr:
-      return objTriple.addrSize == AddressSize::Eight ? 8 : 4;
+      return addrSize == AddressSize::Eight ? 8 : 4;
+    default:
+      return {};
+    }
+  }
 
-    case DWARFType::String:
-    case DWARFType::Exprloc:
-    case DWARFType::ULEB128:
-    case DWARFType::LEB128:
-      assert(0 && "type has dynamic size and should have not been called here");
+  static uint64_t readFixedSize(size_t size, const uint8_t *ptr) {
+    switch (size) {
+    case 1:
+      return *ptr;
+    case 2:
+      return *reinterpret_cast<const uint16_t *>(ptr);
+    case 3:
+      return ptr[0] | ptr[1] << 8 | ptr[2] << 16;
+    case 4:
+      return *reinterpret_cast<const uint32_t *>(ptr);
+    case 8:
+      return *reinterpret_cast<const uint64_t *>(ptr);
+    // DW_FORM_data16, only the low half is kept.
+    case 16:
+      return *reinterpret_cast<const uint64_t *>(ptr);
+    default:
+      assert(0 && "unkown size for type");
       __builtin_trap();
+    }
+  }
 
+  // Variable length forms, other than strings, are only skipped for now and
+  // read as 0.
+  uint64_t readVariableSize(DWARFType type, const uint8_t *&ptr) {
+    switch (type) {
+    case DWARFType::String: {
+      const uint8_t *str = ptr;
+      ptr += std::strlen(reinterpret_cast<const char *>(ptr)) + 1;
+      return reinterpret_cast<uintptr_t>(str);
+    }
+    case DWARFType::ULEB128:
+      return readULEB128(ptr);
+    case DWARFType::LEB128:
+      return static_cast<uint64_t>(readSLEB128(ptr));
+    case DWARFType::Exprloc:
+    case DWARFType::Block: {
+      size_t numToAdvance = readULEB128(ptr);
+      ptr += numToAdvance;
+      return 0;
+    }
+    case DWARFType::Block1:
+    case DWARFType::Block2:
+    case DWARFType::Block4: {
+      size_t lengthSize = type == DWARFType::Block1   ? 1
+                          : type == DWARFType::Block2 ? 2
+                                                      : 4;
+      ptr += lengthSize + readFixedSize(lengthSize, ptr);
+      return 0;
+    }
     default:
       assert(0 && "type was not implemented yet");
       __builtin_trap();
     }
   }
 
-  uint64_t readULEB128(const uint8_t *&ptr) {
-    uint64_t result = 0;
-    for (uint64_t shift = 0;; shift += 7) {
-      uint8_t byte = *ptr++ & 0b01111111;
-      result |= (byte << shift);
-      if (!(byte & 0b10000000))
-        break;
+  // Offsets into a string section. In relocatable objects they're 0 and the
+  // string comes from a relocation at relocOffset in relocSec, otherwise 0 is
+  // a real offset to the first string.
+  uint64_t resolveStringOffset(LazySection &lazyStrSec, uint64_t offset,
+                               const ELF::Section &relocSec,
+                               uint64_t relocOffset) {
+    if (!offset) {
+      ErrorOr<const uint8_t *> resolvedRelocOrErr =
+          elfReader.attemptResolveLocalReloc(relocSec, relocOffset);
+      if (resolvedRelocOrErr)
+        return reinterpret_cast<uintptr_t>(*resolvedRelocOrErr);
     }
-    return result;
+    ELF::Section strSec = lazyStrSec.get();
+    if (!strSec || offset >= strSec.size)
+      return 0;
+    return reinterpret_cast<uintptr_t>(strSec.data) + offset;
   }
 
-  DWARF::Data readFromPointer(DWARFType type, const uint8_t *&ptr) {
-    if (type == DWARFType::String) {
-      std::string str{reinterpret_cast<const char *>(ptr)};
-      ptr += str.size() + 1;
-      return str;
-    }
+  uint64_t resolveStrp(uint64_t data, const uint8_t *strpPtr) {
+    return resolveStringOffset(strings.str, data, debugInfoSec,
+                               strpPtr - debugInfoStart);
+  }
 
-    // TODO reading exprloc's, for now just advance the pointer the right amount
-    // and return 0.
-    if (type == DWARFType::Exprloc) {
-      size_t numToAdvance = readULEB128(ptr);
-      ptr += numToAdvance;
-      return uint64_t{0};
+  uint64_t resolveLineStrp(uint64_t data, const uint8_t *strpPtr) {
+    return resolveStringOffset(strings.lineStr, data, debugInfoSec,
+                               strpPtr - debugInfoStart);
+  }
+
+  uint64_t resolveStrx(uint64_t index) {
+    ELF::Section strOffsets = strings.strOffsets.get();
+    size_t entrySize = currentSecAddrSize == AddressSize::Eight ? 8 : 4;
+    // Without DW_AT_str_offsets_base, a unit's entries start right after the
+    // header of its .debug_str_offsets contribution.
+    if (!strOffsetsBase)
+      strOffsetsBase =
+          findUnitSectionOffset(*unitHeader, DW_AT_str_offsets_base, strOffsets)
+              .value_or(2 * entrySize);
+    uint64_t offset = *strOffsetsBase + index * entrySize;
+    if (offset + entrySize > strOffsets.size)
+      return 0;
+    uint64_t strOffset = readFixedSize(entrySize, strOffsets.data + offset);
+    return resolveStringOffset(strings.str, strOffset, strOffsets, offset);
+  }
+
+  // Reads an attribute according to its spec. Strings are returned as a
+  // pointer to them in the object file, references as .debug_info offsets.
+  uint64_t readAttribute(const AttributeSpec &spec, const uint8_t *&ptr) {
+    const uint8_t *start = ptr;
+    uint64_t value;
+    if (spec.size != AttributeSpec::variableSize) {
+      value = spec.size ? readFixedSize(spec.size, ptr) : spec.implicitValue;
+      ptr += spec.size;
+    } else if (spec.form == DW_FORM_indirect) {
+      uint64_t form = readULEB128(ptr);
+      if (!is_DW_FORM(form) || form == DW_FORM_indirect)
+        return 0;
+      AttributeSpec indirect = spec;
+      indirect.form = get_DW_FORM(form);
+      std::optional<size_t> size = getFixedSize(
+          indirect.form.type, currentSecAddrSize, objTriple.addrSize);
+      indirect.size = size ? *size : AttributeSpec::variableSize;
+      indirect.isUnitRef =
+          indirect.form >= DW_FORM_ref1 && indirect.form <= DW_FORM_ref_udata;
+      indirect.isStringIndex = isStringIndexForm(indirect.form);
+      indirect.isSignature = indirect.form == DW_FORM_ref_sig8;
+      setSupplementaryForm(indirect);
+      indirect.implicitValue = indirect.form == DW_FORM_flag_present;
+      return readAttribute(indirect, ptr);
+    } else {
+      value = readVariableSize(spec.form.type, ptr);
     }
 
-    if (type == DWARFType::ULEB128)
-      return readULEB128(ptr);
+    if (spec.form.type == DWARFType::StringPtr)
+      return resolveStrp(value, start);
+    if (spec.form.type == DWARFType::LineStringPtr)
+      return resolveLineStrp(value, start);
+    if (spec.isStringIndex)
+      return resolveStrx(value);
+    if (spec.isUnitRef)
+      return value + (unitStart - debugInfoStart) + offsetBase;
+    if (spec.form == DW_FORM_ref_addr)
+      return value + offsetBase;
+    if (spec.isSupString)
+      return supFile ? supFile->resolveString(value) : 0;
+    // Without the file, the reference is to a DIE that doesn't exist.
+    if (spec.isSupRef)
+      return supFile ? value + supFile->getOffsetBase() : UINT64_MAX;
+    return value;
+  }
 
-    if (type == DWARFType::LEB128)
-      assert(0 && "LEB128 not yet implemented");
+  static void setSupplementaryForm(AttributeSpec &spec) {
+    spec.isSupRef = spec.form == DW_FORM_GNU_ref_alt ||
+                    spec.form == DW_FORM_ref_sup4 ||
+                    spec.form == DW_FORM_ref_sup8;
+    spec.isSupString =
+        spec.form == DW_FORM_GNU_strp_alt || spec.form == DW_FORM_strp_sup;
+  }
 
-    uint64_t data;
-    size_t size = getDTypeSize(type, ptr);
-    switch (size) {
-    // Hacky way to handle DW_FORM_flag_present
-    case 0:
-      data = 1;
-      break;
-    case 1:
-      data = *ptr;
-      break;
-    case 2:
-      data = *reinterpret_cast<const uint16_t *>(ptr);
-      break;
-    case 4:
-      data = *reinterpret_cast<const uint32_t *>(ptr);
-      break;
-    case 8:
-      data = *reinterpret_cast<const uint64_t *>(ptr);
-      break;
+  void skipAttribute(const AttributeSpec &spec, const uint8_t *&ptr) {
+    if (spec.size != AttributeSpec::variableSize) {
+      ptr += spec.size;
+      return;
+    }
+    switch (spec.form.type) {
+    case DWARFType::String:
+      ptr += std::strlen(reinterpret_cast<const char *>(ptr)) + 1;
+      return;
+    case DWARFType::ULEB128:
+    case DWARFType::LEB128:
+      skipLEB128(ptr);
+      return;
     default:
-      assert(0 && "unkown size for type");
-      __builtin_trap();
+      // Strings aren't resolved and nothing else has a cost when reading.
+      readAttribute(spec, ptr);
     }
-    ptr += size;
+  }
 
-    if (type == DWARFType::StringPtr) {
-      if (!data) {
-        ErrorOr<const uint8_t *> resolvedRelocOrErr =
-            elfReader.attemptResolveLocalReloc(".debug_info",
-                                               ptr - size - debugInfoStart);
-        if (!resolvedRelocOrErr)
-          return std::string{};
-        data = reinterpret_cast<uint64_t>(*resolvedRelocOrErr);
-      } else {
-        const uint8_t *debugStrSec = elfReader.getSection(".debug_str");
-        assert(debugStrSec && "Couldn't find .debug_str");
-        data = reinterpret_cast<uintptr_t>(debugStrSec) + data;
+  static void mergeUnit(DWARF &dwarf, DWARF &&unit) {
+    size_t base = dwarf.debugInfo.size();
+    std::move(unit.debugInfo.begin(), unit.debugInfo.end(),
+              std::back_inserter(dwarf.debugInfo));
+    dwarf.attributeArena.append(std::move(unit.attributeArena));
+    while (!unit.variableIndex.empty()) {
+      auto node = unit.variableIndex.extract(unit.variableIndex.begin());
+      addVariable(dwarf, std::move(node.key()),
+                  node.mapped().dieIndex + base, node.mapped().isDeclaration);
+    }
+  }
+
+  static void addVariable(DWARF &dwarf, std::string &&name, size_t dieIndex,
+                          bool isDeclaration) {
+    auto [it, inserted] = dwarf.variableIndex.try_emplace(
+        std::move(name), dieIndex, isDeclaration);
+    // Prefer definitions over declarations of the same name.
+    if (!inserted && it->second.isDeclaration && !isDeclaration)
+      it->second = {dieIndex, isDeclaration};
+  }
+
+  // Units don't depend on each other, so each is read into its own DWARF on a
+  // pool of threads. They are merged in order at the end. Abbrev tables are
+  // all read up front so the threads can share them. The supplementary file is
+  // opened if they refer to it and options are given.
+  static ErrorOr<DWARF> read(ELF::Section abbrevSec, ELF::Section debugInfo,
+                             const ELF::Reader &elfReader,
+                             DWARF::ParseMode mode,
+                             const std::vector<uint64_t> *unitOffsets,
+                             const DebugFileOptions *options,
+                             uint64_t offsetBase = 0) {
+    ErrorOr<std::vector<UnitHeader>> unitsOrErr =
+        readUnitHeaders(debugInfo, abbrevSec, elfReader, unitOffsets);
+    if (!unitsOrErr)
+      return unitsOrErr.takeError();
+    std::vector<UnitHeader> &units = *unitsOrErr;
+
+    AbbrevCache abbrevCache;
+    for (UnitHeader &unit : units) {
+      auto [it, inserted] =
+          abbrevCache.try_emplace({unit.abbrevOffset, unit.offsetSize});
+      if (inserted)
+        if (Error err = readAbbrevTable(abbrevSec, unit.abbrevOffset,
+                                        unit.offsetSize,
+                                        elfReader.getTriple().addrSize,
+                                        it->second))
+          return err;
+      unit.abbrevTable = &it->second;
+    }
+
+    std::shared_ptr<SupplementaryFile> supFile;
+    if (options && std::any_of(abbrevCache.begin(), abbrevCache.end(),
+                               [](const auto &table) {
+                                 return table.second.usesSupplementaryFile;
+                               })) {
+      ErrorOr<std::shared_ptr<SupplementaryFile>> supFileOrErr =
+          SupplementaryFile::open(elfReader, mode, debugInfo.size, *options);
+      if (!supFileOrErr)
+        return supFileOrErr.takeError();
+      supFile = std::move(*supFileOrErr);
+    }
+
+    // Only the units being read are paged in, and dropped once they're done.
+    // Strings are left alone since DIEs keep pointing to them.
+    const FileReader &file = elfReader.getFileReader();
+    file.willNeed(abbrevSec.data, abbrevSec.size);
+
+    StringSections strings{elfReader, false};
+    std::vector<DWARF> unitDWARFs(units.size());
+    std::vector<Error> errors(units.size());
+    std::atomic<size_t> nextUnit = 0;
+    auto readUnits = [&] {
+      for (size_t i; (i = nextUnit++) < units.size();) {
+        DWARFReader reader{unitDWARFs[i], mode,    elfReader,
+                           debugInfo,     strings, offsetBase};
+        reader.supFile = supFile.get();
+        size_t unitSize = units[i].end - units[i].start;
+        file.willNeed(units[i].start, unitSize);
+        errors[i] = reader.readUnit(units[i]);
+        file.dontNeed(units[i].start, unitSize);
       }
-      return std::string{reinterpret_cast<const char *>(data)};
+    };
+
+    size_t numThreads = std::min<size_t>(
+        units.size(), std::max(1u, std::thread::hardware_concurrency()));
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < numThreads; i++)
+      threads.emplace_back(readUnits);
+    readUnits();
+    for (std::thread &thread : threads)
+      thread.join();
+
+    file.dontNeed(abbrevSec.data, abbrevSec.size);
+
+    for (Error &err : errors)
+      if (err)
+        return std::move(err);
+
+    DWARF dwarf = std::move(unitDWARFs[0]);
+    dwarf.debugInfoStart = debugInfo.data;
+    dwarf.supFile = std::move(supFile);
+    size_t numDIEs = 0;
+    for (const DWARF &unit : unitDWARFs)
+      numDIEs += unit.debugInfo.size();
+    dwarf.debugInfo.reserve(numDIEs);
+    for (size_t i = 1; i < unitDWARFs.size(); i++)
+      mergeUnit(dwarf, std::move(unitDWARFs[i]));
+    return dwarf;
+  }
+
+  static std::shared_ptr<const ObjectFileReader>
+  openObject(const std::string &path) {
+    ErrorOr<FileReader> fileOrErr =
+        FileReader::open(path, FileReader::MapMode::Lazy);
+    if (!fileOrErr)
+      return nullptr;
+    return createObjectFileReader(std::move(*fileOrErr));
+  }
+
+  // Skeleton units only say where their split unit is. It's looked up in a
+  // .dwp package next to the object first, then in the .dwo file the unit
+  // names, relative to its compilation directory or the object's directory.
+  static Error findSplitUnit(SplitUnit &splitUnit, const ELF::Reader *package,
+                             ELF::Section cuIndex,
+                             const DebugFileOptions &options) {
+    if (cuIndex)
+      if (auto contribution =
+              DWARFPackage::findUnit(cuIndex, splitUnit.dwoID)) {
+        splitUnit.contribution = *contribution;
+        splitUnit.reader = package;
+        return {};
+      }
+
+    std::string dwoName{splitUnit.dwoName};
+    std::vector<std::string> candidates;
+    if (dwoName.front() == '/') {
+      candidates.push_back(dwoName);
+    } else {
+      if (!splitUnit.compDir.empty())
+        candidates.push_back(std::string{splitUnit.compDir} + '/' + dwoName);
+      size_t slash = options.objectPath.rfind('/');
+      candidates.push_back(slash == std::string::npos
+                               ? dwoName
+                               : options.objectPath.substr(0, slash + 1) +
+                                     dwoName);
+    }
+    for (const std::string &path : candidates) {
+      splitUnit.dwoFile = openObject(path);
+      splitUnit.reader =
+          dynamic_cast<const ELF::Reader *>(splitUnit.dwoFile.get());
+      if (!splitUnit.reader)
+        continue;
+      splitUnit.contribution = {};
+      splitUnit.contribution.infoSize =
+          splitUnit.reader->getSection(".debug_info.dwo").size;
+      return {};
     }
+    return Error("Couldn't find split DWARF file '"s + dwoName + '\'',
+                 Error::Code::NotFound);
+  }
 
-    return data;
-  };
+  static Error readSplitUnit(const SplitUnit &splitUnit, DWARF::ParseMode mode,
+                             uint64_t offsetBase, DWARF &dwarf) {
+    const ELF::Reader &dwoReader = *splitUnit.reader;
+    ELF::Section abbrevSec = dwoReader.getSection(".debug_abbrev.dwo");
+    ELF::Section debugInfo = dwoReader.getSection(".debug_info.dwo");
+    const DWARFPackage::UnitContribution &contribution =
+        splitUnit.contribution;
+    if (!abbrevSec || !debugInfo)
+      return Error::notFound(
+          "Couldn't find .debug_abbrev.dwo or .debug_info.dwo");
+    if (contribution.infoOffset >= debugInfo.size)
+      return Error::malformed("Malformed DWARF: split unit offset '{}' is past "
+                              "the end of .debug_info.dwo",
+                              contribution.infoOffset);
 
-  static ErrorOr<DWARF> read(const uint8_t *abbrevSec, const uint8_t *debugInfo,
-                             const char *objectFileStart,
-                             const ELF::Reader &elfReader) {
-    DWARF dwarf;
-    dwarf.debugInfoStart = debugInfo;
-    DWARFReader reader{dwarf, elfReader, objectFileStart, abbrevSec, debugInfo};
+    UnitHeader header;
+    if (Error err =
+            readUnitHeader(debugInfo, abbrevSec, dwoReader,
+                           debugInfo.data + contribution.infoOffset, header))
+      return err;
+    header.abbrevOffset += contribution.abbrevOffset;
+    // DWARF 5 string offset tables start with a header, GNU ones don't.
+    header.strOffsetsBase = contribution.strOffsetsOffset;
+    if (header.version >= 5)
+      *header.strOffsetsBase +=
+          header.offsetSize == AddressSize::Eight ? 16 : 8;
+    AbbrevTable abbrevTable;
+    if (Error err = readAbbrevTable(abbrevSec, header.abbrevOffset,
+                                    header.offsetSize,
+                                    dwoReader.getTriple().addrSize,
+                                    abbrevTable))
+      return err;
+    header.abbrevTable = &abbrevTable;
 
-    if (std::string err = reader.readAbbrevTable(); err != std::string{})
+    StringSections strings{dwoReader, true};
+    DWARFReader reader{dwarf, mode, dwoReader, debugInfo, strings, offsetBase};
+    const FileReader &file = dwoReader.getFileReader();
+    size_t unitSize = header.end - header.start;
+    file.willNeed(header.start, unitSize);
+    Error err = reader.readUnit(header);
+    file.dontNeed(header.start, unitSize);
+    if (err)
       return err;
-    if (std::string err = reader.readDebugInfo(); err != std::string{})
+
+    // A stale .dwo from an earlier build.
+    std::optional<uint64_t> dwoID;
+    if (header.version >= 5)
+      dwoID = header.dwoID;
+    else if (!dwarf.debugInfo.empty())
+      if (auto attr =
+              dwarf.debugInfo[0].getAttributeIfPresent(DW_AT_GNU_dwo_id))
+        dwoID = std::get<uint64_t>(*attr);
+    if (dwoID != splitUnit.dwoID)
+      return Error("Split unit '"s + std::string{splitUnit.dwoName} +
+                       "' doesn't match its skeleton unit",
+                   Error::Code::Malformed);
+    return {};
+  }
+
+  // Replaces the skeleton units read from an object built with -gsplit-dwarf
+  // with their split units. Only the units that were read are looked up, so
+  // with a name index only the .dwo files defining the names are opened.
+  // Split units' offsets start at nextOffset, which is moved past them.
+  static ErrorOr<DWARF> readSplitUnits(DWARF &&dwarf, ELF::Section debugInfo,
+                                       uint64_t &nextOffset,
+                                       DWARF::ParseMode mode,
+                                       const DebugFileOptions &options) {
+    std::vector<SplitUnit> splitUnits;
+    for (const DWARF::DIE &die : dwarf.debugInfo) {
+      uint64_t dwoID;
+      std::optional<DWARF::Data> dwoName;
+      if (die.tag == DW_TAG_skeleton_unit) {
+        // DWARF 5 puts the ID at the end of the unit header, which comes
+        // right before the unit's DIE.
+        dwoName = die.getAttributeIfPresent(DW_AT_dwo_name);
+        if (die.offset < 8)
+          continue;
+        dwoID = *reinterpret_cast<const uint64_t *>(debugInfo.data +
+                                                    die.offset - 8);
+      } else if (die.tag == DW_TAG_compile_unit) {
+        dwoName = die.getAttributeIfPresent(DW_AT_GNU_dwo_name);
+        auto dwoIDAttr = die.getAttributeIfPresent(DW_AT_GNU_dwo_id);
+        if (!dwoIDAttr)
+          continue;
+        dwoID = std::get<uint64_t>(*dwoIDAttr);
+      } else {
+        continue;
+      }
+      if (!dwoName || std::get<std::string_view>(*dwoName).empty())
+        continue;
+      auto compDir = die.getAttributeIfPresent(DW_AT_comp_dir);
+      splitUnits.push_back(
+          {std::get<std::string_view>(*dwoName),
+           compDir ? std::get<std::string_view>(*compDir) : std::string_view{},
+           dwoID});
+    }
+    if (splitUnits.empty())
+      return std::move(dwarf);
+
+    std::shared_ptr<const ObjectFileReader> package;
+    if (!options.objectPath.empty())
+      package = openObject(options.objectPath + ".dwp");
+    auto *packageReader = dynamic_cast<const ELF::Reader *>(package.get());
+    ELF::Section cuIndex;
+    if (packageReader)
+      cuIndex = packageReader->getSection(".debug_cu_index");
+
+    // Each split unit's offsets come after the last one's.
+    std::vector<uint64_t> offsetBases;
+    for (SplitUnit &splitUnit : splitUnits) {
+      if (Error err = findSplitUnit(splitUnit, packageReader, cuIndex, options))
+        return err;
+      offsetBases.push_back(nextOffset - splitUnit.contribution.infoOffset);
+      nextOffset += splitUnit.contribution.infoSize;
+    }
+
+    std::vector<DWARF> unitDWARFs(splitUnits.size());
+    std::vector<Error> errors(splitUnits.size());
+    std::atomic<size_t> nextUnit = 0;
+    auto readUnits = [&] {
+      for (size_t i; (i = nextUnit++) < splitUnits.size();)
+        errors[i] =
+            readSplitUnit(splitUnits[i], mode, offsetBases[i], unitDWARFs[i]);
+    };
+    size_t numThreads = std::min<size_t>(
+        splitUnits.size(), std::max(1u, std::thread::hardware_concurrency()));
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < numThreads; i++)
+      threads.emplace_back(readUnits);
+    readUnits();
+    for (std::thread &thread : threads)
+      thread.join();
+
+    for (Error &err : errors)
+      if (err)
+        return std::move(err);
+
+    if (cuIndex)
+      dwarf.files.push_back(std::move(package));
+    for (size_t i = 0; i < splitUnits.size(); i++) {
+      mergeUnit(dwarf, std::move(unitDWARFs[i]));
+      if (splitUnits[i].dwoFile)
+        dwarf.files.push_back(std::move(splitUnits[i].dwoFile));
+    }
+    return std::move(dwarf);
+  }
+
+  static ErrorOr<DWARF> readAndResolveSplitUnits(
+      ELF::Section abbrevSec, ELF::Section debugInfo,
+      const ELF::Reader &elfReader, DWARF::ParseMode mode,
+      const std::vector<uint64_t> *unitOffsets,
+      const DebugFileOptions &options) {
+    ErrorOr<DWARF> dwarfOrErr =
+        read(abbrevSec, debugInfo, elfReader, mode, unitOffsets, &options);
+    if (!dwarfOrErr)
+      return dwarfOrErr;
+    // Other DIEs get offsets after those of the object and its supplementary
+    // file.
+    uint64_t nextOffset = dwarfOrErr->supFile
+                              ? dwarfOrErr->supFile->getEndOffset()
+                              : debugInfo.size;
+    dwarfOrErr = readSplitUnits(std::move(*dwarfOrErr), debugInfo, nextOffset,
+                                mode, options);
+    if (!dwarfOrErr)
+      return dwarfOrErr;
+    if (Error err = indexTypeUnits(*dwarfOrErr, abbrevSec, debugInfo,
+                                   nextOffset, elfReader, mode))
       return err;
-    return dwarf;
+    return dwarfOrErr;
+  }
+
+  // Finds the type units DW_FORM_ref_sig8 references can reach, without
+  // reading them.
+  static Error indexTypeUnits(DWARF &dwarf, ELF::Section abbrevSec,
+                              ELF::Section debugInfo, uint64_t nextOffset,
+                              const ELF::Reader &elfReader,
+                              DWARF::ParseMode mode);
+
+  // dwz moves DIEs shared by units into partial units they import, which
+  // aren't read along with them. Those in the supplementary file are read when
+  // needed.
+  static bool importsPartialUnit(const DWARF &dwarf, ELF::Section debugInfo) {
+    return std::any_of(
+        dwarf.debugInfo.begin(), dwarf.debugInfo.end(),
+        [&](const DWARF::DIE &die) {
+          if (die.tag != DW_TAG_imported_unit)
+            return false;
+          auto import = die.getAttributeIfPresent(DW_AT_import);
+          return import && std::get<uint64_t>(*import) < debugInfo.size;
+        });
   }
 
 public:
-  static ErrorOr<DWARF> readFromELFObject(const ELF::Reader &elfReader) {
-    const uint8_t *abbrevSec = elfReader.getSection(".debug_abbrev");
-    const uint8_t *debugInfo = elfReader.getSection(".debug_info");
-    const char *objectFileStart = elfReader.getFileReader().getFileBuffer();
-    return read(abbrevSec, debugInfo, objectFileStart, elfReader);
+  static void addFile(DWARF &dwarf,
+                      std::shared_ptr<const ObjectFileReader> file) {
+    dwarf.files.push_back(std::move(file));
+  }
+
+  // If names is given only the units the name index says define them are
+  // read. Without an index, or if it's missing any of them, every unit is.
+  static ErrorOr<DWARF>
+  readFromELFObject(const ELF::Reader &elfReader, DWARF::ParseMode mode,
+                    const std::vector<std::string_view> *names,
+                    const DebugFileOptions &options) {
+    ELF::Section abbrevSec = elfReader.getSection(".debug_abbrev");
+    ELF::Section debugInfo = elfReader.getSection(".debug_info");
+    if (!abbrevSec || !debugInfo)
+      return Error::notFound("Couldn't find .debug_abbrev or .debug_info");
+    std::optional<std::vector<uint64_t>> unitOffsets;
+    if (names)
+      unitOffsets = DWARFNameIndex::findUnits(elfReader, *names);
+    if (!unitOffsets)
+      return readAndResolveSplitUnits(abbrevSec, debugInfo, elfReader, mode,
+                                      nullptr, options);
+
+    ErrorOr<DWARF> dwarfOrErr = readAndResolveSplitUnits(
+        abbrevSec, debugInfo, elfReader, mode, &*unitOffsets, options);
+    // The index can be stale or name something other than a variable.
+    if (dwarfOrErr &&
+        std::all_of(names->begin(), names->end(),
+                    [&](std::string_view name) {
+                      return dwarfOrErr->findVariable(name);
+                    }) &&
+        !importsPartialUnit(*dwarfOrErr, debugInfo))
+      return dwarfOrErr;
+    return readAndResolveSplitUnits(abbrevSec, debugInfo, elfReader, mode,
+                                    nullptr, options);
   }
 };
 
-std::string DWARFReader::readAbbrevTable() {
-  const uint8_t *abbrevPtr = abbrevSecStart;
-  // Put fake abbrev 0
-  abbrevTable.emplace_back();
+// Type units are found by signature when the object is read, but their DIEs
+// are only read once something references them. Their offsets don't overlap
+// those of the DWARF's own DIEs, so references within a unit resolve through
+// DWARF::getDIEFromOffset.
+class TypeUnits {
+  struct Unit {
+    DWARFReader::UnitHeader header;
+    ELF::Section section;
+    uint64_t offsetBase;
+    // Offsets of the unit and its type DIE, like those of DIEs.
+    uint64_t start;
+    uint64_t end;
+    uint64_t typeOffset;
+    // Read the first time a reference reaches the unit.
+    std::unique_ptr<DWARF> dwarf;
+    bool failed = false;
+  };
 
-  const auto readAbbrev = [&abbrevPtr](Abbrev &currentAbbrev) {
-    currentAbbrev.tag = DW_TAG{*abbrevPtr++};
-    currentAbbrev.children = *abbrevPtr++;
+  const ELF::Reader &elfReader;
+  const DWARF::ParseMode mode;
+  const ELF::Section abbrevSec;
+  DWARFReader::StringSections strings;
+  DWARFReader::AbbrevCache abbrevCache;
+  // Sorted by start.
+  std::vector<Unit> units;
+  std::unordered_map<uint64_t, size_t> signatures;
 
-    for (;;) {
-      DW_AT attribute{*abbrevPtr++};
-      uint8_t form = *abbrevPtr++;
+  const DWARF *readUnit(Unit &unit);
+
+public:
+  TypeUnits(const ELF::Reader &elfReader, DWARF::ParseMode mode,
+            ELF::Section abbrevSec)
+      : elfReader(elfReader), mode(mode), abbrevSec(abbrevSec),
+        strings(elfReader, false) {}
 
-      if (!attribute && !form)
-        return;
+  static Error index(DWARF &dwarf, ELF::Section abbrevSec,
+                     ELF::Section debugInfo, uint64_t nextOffset,
+                     const ELF::Reader &elfReader, DWARF::ParseMode mode);
 
-      currentAbbrev.attributes.emplace_back(attribute, get_DW_FORM(form));
+  const DWARF::DIE *findDIE(uint64_t signature);
+  const DWARF::DIE *findDIEFromOffset(uint64_t offset);
+};
+
+Error TypeUnits::index(DWARF &dwarf, ELF::Section abbrevSec,
+                       ELF::Section debugInfo, uint64_t nextOffset,
+                       const ELF::Reader &elfReader, DWARF::ParseMode mode) {
+  // DWARF 4 type units have their own sections, DWARF 5 ones are in
+  // .debug_info. Relocatable objects have a section for each type in a COMDAT
+  // group, so the linker can keep just one copy.
+  bool inDebugInfo = dwarf.version >= 5;
+  std::vector<ELF::Section> sections =
+      elfReader.getSections(inDebugInfo ? ".debug_info" : ".debug_types");
+  if (sections.empty())
+    return {};
+
+  auto typeUnits = std::make_shared<TypeUnits>(elfReader, mode, abbrevSec);
+  // Sections other than the main .debug_info get offsets from nextOffset on,
+  // like split units do.
+  for (const ELF::Section &section : sections) {
+    uint64_t offsetBase = 0;
+    if (section.data != debugInfo.data) {
+      offsetBase = nextOffset;
+      nextOffset += section.size;
     }
-  };
+    const uint8_t *const end = section.data + section.size;
+    for (const uint8_t *unit = section.data; unit < end;) {
+      DWARFReader::UnitHeader header;
+      if (Error err = DWARFReader::readUnitHeader(
+              section, abbrevSec, elfReader, unit, header, !inDebugInfo))
+        return err;
+      unit = header.end;
+      if (!DWARFReader::isTypeUnit(header))
+        continue;
+      uint64_t start = header.start - section.data + offsetBase;
+      typeUnits->units.push_back({header, section, offsetBase, start,
+                                  header.end - section.data + offsetBase,
+                                  start + header.typeOffset});
+    }
+  }
+  if (typeUnits->units.empty())
+    return {};
+
+  std::vector<Unit> &units = typeUnits->units;
+  std::sort(units.begin(), units.end(), [](const Unit &a, const Unit &b) {
+    return a.start < b.start;
+  });
+  for (size_t i = 0; i < units.size(); i++)
+    typeUnits->signatures.emplace(units[i].header.signature, i);
+  dwarf.typeUnits = std::move(typeUnits);
+  return {};
+}
+
+const DWARF *TypeUnits::readUnit(Unit &unit) {
+  if (unit.dwarf || unit.failed)
+    return unit.dwarf.get();
+  unit.failed = true;
 
-  for (int expectedCode = 1;; expectedCode++) {
-    uint8_t abbrevCode = *abbrevPtr++;
+  DWARFReader::UnitHeader &header = unit.header;
+  auto [it, inserted] =
+      abbrevCache.try_emplace({header.abbrevOffset, header.offsetSize});
+  if (inserted)
+    if (DWARFReader::readAbbrevTable(abbrevSec, header.abbrevOffset,
+                                     header.offsetSize,
+                                     elfReader.getTriple().addrSize,
+                                     it->second)) {
+      abbrevCache.erase(it);
+      return nullptr;
+    }
+  header.abbrevTable = &it->second;
 
+  auto dwarf = std::make_unique<DWARF>();
+  DWARFReader reader{*dwarf, mode, elfReader, unit.section, strings,
+                     unit.offsetBase};
+  if (reader.readUnit(header))
+    return nullptr;
+  unit.failed = false;
+  unit.dwarf = std::move(dwarf);
+  return unit.dwarf.get();
+}
+
+const DWARF::DIE *TypeUnits::findDIE(uint64_t signature) {
+  auto it = signatures.find(signature);
+  if (it == signatures.end())
+    return nullptr;
+  return findDIEFromOffset(units[it->second].typeOffset);
+}
+
+const DWARF::DIE *TypeUnits::findDIEFromOffset(uint64_t offset) {
+  auto it = std::upper_bound(
+      units.begin(), units.end(), offset,
+      [](uint64_t offset, const Unit &unit) { return offset < unit.start; });
+  if (it == units.begin() || offset >= std::prev(it)->end)
+    return nullptr;
+  const DWARF *dwarf = readUnit(*std::prev(it));
+  if (!dwarf)
+    return nullptr;
+  const std::vector<DWARF::DIE> &dies = dwarf->debugInfo;
+  auto die = std::lower_bound(
+      dies.begin(), dies.end(), offset,
+      [](const DWARF::DIE &d, uint64_t offset) { return d.offset < offset; });
+  return die == dies.end() || die->offset != offset ? nullptr
+                                                    : std::addressof(*die);
+}
+
+Error DWARFReader::indexTypeUnits(DWARF &dwarf, ELF::Section abbrevSec,
+                                  ELF::Section debugInfo, uint64_t nextOffset,
+                                  const ELF::Reader &elfReader,
+                                  DWARF::ParseMode mode) {
+  return TypeUnits::index(dwarf, abbrevSec, debugInfo, nextOffset, elfReader,
+                          mode);
+}
+
+const DWARF::DIE *SupplementaryFile::findDIEFromOffset(uint64_t offset) {
+  std::call_once(once, [this] {
+    if (!abbrevSec || !debugInfo)
+      return;
+    ErrorOr<DWARF> dwarfOrErr = DWARFReader::read(
+        abbrevSec, debugInfo, reader, mode, nullptr, nullptr, offsetBase);
+    if (dwarfOrErr)
+      dwarf = std::make_unique<DWARF>(std::move(*dwarfOrErr));
+  });
+  if (!dwarf)
+    return nullptr;
+  const std::vector<DWARF::DIE> &dies = dwarf->debugInfo;
+  auto die = std::lower_bound(
+      dies.begin(), dies.end(), offset,
+      [](const DWARF::DIE &d, uint64_t offset) { return d.offset < offset; });
+  return die == dies.end() || die->offset != offset ? nullptr
+                                                    : std::addressof(*die);
+}
+
+const DWARF::DIE *
+DWARF::getSupplementaryDIEFromOffset(uint64_t offset) const {
+  return supFile ? supFile->findDIEFromOffset(offset) : nullptr;
+}
+
+const DWARF::DIE *DWARF::getTypeUnitDIE(uint64_t signature) const {
+  return typeUnits ? typeUnits->findDIE(signature) : nullptr;
+}
+
+const DWARF::DIE *DWARF::getTypeUnitDIEFromOffset(uint64_t offset) const {
+  return typeUnits ? typeUnits->findDIEFromOffset(offset) : nullptr;
+}
+
+Error DWARFReader::readAbbrevTable(ELF::Section abbrevSec, uint64_t offset,
+                                   AddressSize offsetSize,
+                                   AddressSize addrSize, AbbrevTable &table) {
+  if (offset >= abbrevSec.size)
+    return Error::malformed(
+        "Malformed DWARF: abbrev offset '{}' is past the end of .debug_abbrev",
+        offset);
+  const uint8_t *abbrevPtr = abbrevSec.data + offset;
+  const uint8_t *end = abbrevSec.data + abbrevSec.size;
+  const Error unterminated = Error::malformed(
+      "Malformed DWARF: abbrev table at offset '{}' isn't terminated", offset);
+
+  for (;;) {
+    if (abbrevPtr >= end)
+      return unterminated;
+    uint64_t abbrevCode = readULEB128(abbrevPtr);
     if (!abbrevCode)
       return {};
 
-    if (abbrevCode != expectedCode)
-      return "Error parsing DWARF, expected Abbreviation code '"s +
-             std::to_string(expectedCode) + "' but found '" +
-             std::to_string(abbrevCode) + '\'';
+    Abbrev &abbrev = table.add(abbrevCode);
+    uint64_t tag = readULEB128(abbrevPtr);
+    if (tag > UINT16_MAX)
+      return Error::unsupported("Unknown DW_TAG: '{}'", tag);
+    abbrev.tag = DW_TAG{static_cast<uint16_t>(tag)};
+    abbrev.children = *abbrevPtr++;
 
-    readAbbrev(abbrevTable.emplace_back());
+    size_t fixedSize = 0;
+    bool isFixedSize = true;
+    for (;;) {
+      if (abbrevPtr >= end)
+        return unterminated;
+      uint64_t attr = readULEB128(abbrevPtr);
+      uint64_t form = readULEB128(abbrevPtr);
+      if (!attr && !form)
+        break;
+
+      if (attr > UINT16_MAX)
+        return Error::unsupported("Unknown DW_AT: '{}'", attr);
+      if (!is_DW_FORM(form))
+        return Error::unsupported("Unknown DW_FORM: '{}'", form);
+
+      AttributeSpec &spec = abbrev.attributes.emplace_back();
+      spec.attr = DW_AT{static_cast<uint16_t>(attr)};
+      spec.form = get_DW_FORM(form);
+      spec.isStringIndex = isStringIndexForm(spec.form);
+      spec.isString = spec.form.type == DWARFType::String ||
+                      spec.form.type == DWARFType::StringPtr ||
+                      spec.form.type == DWARFType::LineStringPtr ||
+                      spec.isStringIndex;
+      spec.isUnitRef =
+          spec.form >= DW_FORM_ref1 && spec.form <= DW_FORM_ref_udata;
+      spec.isSignature = spec.form == DW_FORM_ref_sig8;
+      setSupplementaryForm(spec);
+      spec.isString |= spec.isSupString;
+      table.usesSupplementaryFile |= spec.isSupRef || spec.isSupString;
+      // The value of DW_FORM_implicit_const is kept in the abbrev itself.
+      if (spec.form == DW_FORM_implicit_const)
+        spec.implicitValue = static_cast<uint64_t>(readSLEB128(abbrevPtr));
+      else
+        spec.implicitValue = spec.form == DW_FORM_flag_present;
+      if (std::optional<size_t> size =
+              getFixedSize(spec.form.type, offsetSize, addrSize)) {
+        spec.size = *size;
+        fixedSize += *size;
+      } else {
+        spec.size = AttributeSpec::variableSize;
+        isFixedSize = false;
+      }
+      if (spec.attr == DW_AT_sibling)
+        abbrev.hasSibling = true;
+    }
+    if (isFixedSize)
+      abbrev.fixedSize = fixedSize;
+    setSkipSteps(abbrev);
   }
+}
 
-  __builtin_unreachable();
+void DWARFReader::setSkipSteps(Abbrev &abbrev) {
+  SkipStep step;
+  for (size_t i = 0; i < abbrev.attributes.size(); i++) {
+    const AttributeSpec &spec = abbrev.attributes[i];
+    bool isLEB128 = spec.form.type == DWARFType::ULEB128 ||
+                    spec.form.type == DWARFType::LEB128;
+    if (spec.attr != DW_AT_sibling &&
+        spec.size != AttributeSpec::variableSize && !step.numLEB128s) {
+      step.fixedSize += spec.size;
+    } else if (spec.attr != DW_AT_sibling && isLEB128 &&
+               step.numLEB128s < UINT16_MAX) {
+      step.numLEB128s++;
+    } else {
+      step.index = static_cast<uint16_t>(i);
+      abbrev.skipSteps.push_back(step);
+      step = {};
+    }
+  }
+  if (step.fixedSize || step.numLEB128s)
+    abbrev.skipSteps.push_back(step);
 }
 
-std::string DWARFReader::readDebugInfo() {
-  const uint8_t *debugInfo = debugInfoStart;
+Error DWARFReader::readUnitHeader(ELF::Section debugInfo,
+                                  ELF::Section abbrevSec,
+                                  const ELF::Reader &elfReader,
+                                  const uint8_t *unit, UnitHeader &header,
+                                  bool isTypesSection) {
+  const uint8_t *const end = debugInfo.data + debugInfo.size;
+  header.start = unit;
+  const Error badLength = Error::malformed(
+      "Malformed DWARF: unit at offset '{}' has a bad initial length",
+      unit - debugInfo.data);
 
-  uint64_t size =
-      std::get<uint64_t>(readFromPointer(DWARFType::Four, debugInfo));
+  const uint8_t *ptr = unit;
+  if (end - ptr < 4)
+    return badLength;
+  uint64_t size = *reinterpret_cast<const uint32_t *>(ptr);
+  ptr += 4;
+  header.offsetSize = AddressSize::Four;
   if (size == 0xffffffff) {
-    size = std::get<uint64_t>(readFromPointer(DWARFType::Eight, debugInfo));
-    currentSecAddrSize = AddressSize::Eight;
+    if (end - ptr < 8)
+      return badLength;
+    size = *reinterpret_cast<const uint64_t *>(ptr);
+    ptr += 8;
+    header.offsetSize = AddressSize::Eight;
+  } else if (size >= 0xfffffff0) {
+    return Error::malformed("Malformed DWARF: initial length field has first "
+                            "four bytes of value: {}",
+                            size);
+  }
+  if (size > static_cast<uint64_t>(end - ptr))
+    return badLength;
+  header.end = ptr + size;
+
+  size_t offsetSize = header.offsetSize == AddressSize::Eight ? 8 : 4;
+  if (size < 2)
+    return Error::malformed(
+        "Debug info section is too small for needed data");
+  header.version = *reinterpret_cast<const uint16_t *>(ptr);
+  ptr += 2;
+  if (header.version < 2 || header.version > 5)
+    return Error::unsupported("Unknown DWARF version: '{}'", header.version);
+
+  // DWARF 5 moved the address size before the abbrev offset and added a unit
+  // type, which some units follow with extra fields.
+  header.unitType = DW_UT_compile;
+  header.dwoID = 0;
+  uint8_t addrSize = 0;
+  size_t extraSize = 0;
+  if (header.version >= 5) {
+    if (size < 4 + offsetSize)
+      return Error::malformed(
+          "Debug info section is too small for needed data");
+    header.unitType = *ptr++;
+    addrSize = *ptr++;
+    switch (header.unitType) {
+    case DW_UT_compile:
+    case DW_UT_partial:
+      break;
+    case DW_UT_skeleton:
+    case DW_UT_split_compile:
+      extraSize = 8;
+      break;
+    case DW_UT_type:
+    case DW_UT_split_type:
+      extraSize = 8 + offsetSize;
+      break;
+    default:
+      return Error::unsupported("Unknown DWARF unit type: '{}'",
+                                header.unitType);
+    }
+    if (size < 4 + offsetSize + extraSize)
+      return Error::malformed(
+          "Debug info section is too small for needed data");
   } else {
-    if (size >= 0xfffffff0)
-      return "Malformed DWARF: initial length field has first four bytes of value: "s +
-             std::to_string(size);
-    currentSecAddrSize = AddressSize::Four;
-  }
-  if (size < 7)
-    return "Debug info section is too small for needed data";
-  const uint8_t *end = debugInfo - 1 + size;
-  uint64_t versionNum =
-      std::get<uint64_t>(readFromPointer(DWARFType::Two, debugInfo));
-  uint64_t abbrevOffset =
-      std::get<uint64_t>(readFromPointer(DWARFType::Four, debugInfo));
-  uint64_t addrSize =
-      std::get<uint64_t>(readFromPointer(DWARFType::One, debugInfo));
-
-  if (versionNum > 4)
-    return "Unknown DWARF version: '"s + std::to_string(versionNum) + '\'';
-  if (addrSize != (objTriple.addrSize == AddressSize::Eight ? 8 : 4))
-    return "Malformed DWARF: should have same address size as it's ELF file";
-
-  dwarf.version = static_cast<uint16_t>(versionNum);
+    if (isTypesSection) {
+      header.unitType = DW_UT_type;
+      extraSize = 8 + offsetSize;
+    }
+    if (size < 3 + offsetSize + extraSize)
+      return Error::malformed(
+          "Debug info section is too small for needed data");
+  }
+
+  header.abbrevOffset = readFixedSize(offsetSize, ptr);
+  // In relocatable objects the offset is filled in by a relocation.
+  if (!header.abbrevOffset)
+    if (ErrorOr<const uint8_t *> resolvedRelocOrErr =
+            elfReader.attemptResolveLocalReloc(debugInfo, ptr - debugInfo.data))
+      header.abbrevOffset = *resolvedRelocOrErr - abbrevSec.data;
+  ptr += offsetSize;
+  if (header.version < 5)
+    addrSize = *ptr++;
+  if (header.unitType == DW_UT_skeleton ||
+      header.unitType == DW_UT_split_compile)
+    header.dwoID = *reinterpret_cast<const uint64_t *>(ptr);
+  if (isTypeUnit(header)) {
+    header.signature = *reinterpret_cast<const uint64_t *>(ptr);
+    header.typeOffset = readFixedSize(offsetSize, ptr + 8);
+  }
+  ptr += extraSize;
+  header.firstDIE = ptr;
+
+  if (addrSize !=
+      (elfReader.getTriple().addrSize == AddressSize::Eight ? 8 : 4))
+    return Error::malformed(
+        "Malformed DWARF: should have same address size as it's ELF file");
+  return {};
+}
+
+ErrorOr<std::vector<DWARFReader::UnitHeader>>
+DWARFReader::readUnitHeaders(ELF::Section debugInfo, ELF::Section abbrevSec,
+                             const ELF::Reader &elfReader,
+                             const std::vector<uint64_t> *unitOffsets) {
+  std::vector<UnitHeader> units;
+  if (unitOffsets) {
+    for (uint64_t offset : *unitOffsets) {
+      if (offset >= debugInfo.size)
+        return Error::malformed(
+            "Malformed DWARF: unit offset '{}' is past the end of .debug_info",
+            offset);
+      if (Error err = readUnitHeader(debugInfo, abbrevSec, elfReader,
+                                     debugInfo.data + offset,
+                                     units.emplace_back()))
+        return err;
+    }
+  } else {
+    const uint8_t *const end = debugInfo.data + debugInfo.size;
+    for (const uint8_t *unit = debugInfo.data; unit < end;) {
+      UnitHeader &header = units.emplace_back();
+      if (Error err =
+              readUnitHeader(debugInfo, abbrevSec, elfReader, unit, header))
+        return err;
+      unit = header.end;
+      // DWARF 5 type units share .debug_info, they're read on demand.
+      if (isTypeUnit(header))
+        units.pop_back();
+    }
+  }
+  if (units.empty())
+    return Error::malformed(
+        "Debug info section is too small for needed data");
+  return units;
+}
+
+std::optional<uint64_t>
+DWARFReader::findUnitSectionOffset(const UnitHeader &header, DW_AT attr,
+                                   ELF::Section section) {
+  const uint8_t *ptr = header.firstDIE;
+  if (ptr >= header.end)
+    return {};
+  const Abbrev *abbrev = abbrevTable->find(readULEB128(ptr));
+  if (!abbrev)
+    return {};
+  for (const AttributeSpec &spec : abbrev->attributes) {
+    if (spec.attr != attr) {
+      skipAttribute(spec, ptr);
+      continue;
+    }
+    const uint8_t *start = ptr;
+    uint64_t offset = readAttribute(spec, ptr);
+    // In relocatable objects the offset is filled in by a relocation.
+    if (!offset)
+      if (ErrorOr<const uint8_t *> resolvedRelocOrErr =
+              elfReader.attemptResolveLocalReloc(debugInfoSec,
+                                                 start - debugInfoStart))
+        offset = *resolvedRelocOrErr - section.data;
+    return offset;
+  }
+  return {};
+}
+
+Error DWARFReader::readUnit(const UnitHeader &header) {
+  unitStart = header.start;
+  currentSecAddrSize = header.offsetSize;
+  abbrevTable = header.abbrevTable;
+  unitHeader = &header;
+  strOffsetsBase = header.strOffsetsBase;
+
+  dwarf.version = header.version;
   dwarf.addrSize = objTriple.addrSize;
-  dwarf.debugInfo.reserve(abbrevTable.size());
 
-  while (debugInfo < end)
-    if (std::string err =
-            readOneDIE(debugInfo, reinterpret_cast<const uint8_t *>(end));
-        err != std::string{})
+  const uint8_t *debugInfo = header.firstDIE;
+  while (debugInfo < header.end)
+    if (Error err = readOneDIE(debugInfo, header.end))
       return err;
 
   assert(!parentDIEs.size() &&
          "Didn't find all end of child marks for DIEs with children");
+  assert(scopePrefixes.size() == parentDIEs.size());
   return {};
 }
 
-std::string DWARFReader::readOneDIE(const uint8_t *&debugInfo,
-                                    const uint8_t *end) {
+Error DWARFReader::readOneDIE(const uint8_t *&debugInfo,
+                              const uint8_t *end) {
   if (debugInfo == end)
-    return "Malformed DWARF: expected another DIE but debug_info section has "
-           "ended";
+    return Error::malformed("Malformed DWARF: expected another DIE but "
+                            "debug_info section has ended");
 
-  uint64_t offset = debugInfo - debugInfoStart;
+  uint64_t offset = debugInfo - debugInfoStart + offsetBase;
+
+  uint64_t abbrevCode = readULEB128(debugInfo);
+
+  // End of child mark
+  if (!abbrevCode) {
+    if (parentDIEs.size()) {
+      parentDIEs.pop();
+      scopePrefixes.pop();
+    }
+    return {};
+  }
 
-  uint64_t abbrevCode =
-      std::get<uint64_t>(readFromPointer(DWARFType::One, debugInfo));
+  const Abbrev *abbrev = abbrevTable->find(abbrevCode);
+  if (!abbrev)
+    return Error::malformed(
+        "Malformed DWARF: Abbrev. Code '{}' isn't in the unit's abbrev table",
+        abbrevCode);
 
-  if (abbrevCode >= abbrevTable.size())
-    return "Malformed DWARF: Abbrev. Code '"s + std::to_string(abbrevCode) +
-           "' is larger than largest known abbrev code '" +
-           std::to_string(abbrevTable.size()) + '\'';
+  const Abbrev &currentDieType = *abbrev;
+  if (mode == DWARF::ParseMode::VariablesAndTypes) {
+    DW_TAG tag = currentDieType.tag;
+    // Nothing in a function can be named from outside of it.
+    if (tag == DW_TAG_subprogram || tag == DW_TAG_lexical_block ||
+        tag == DW_TAG_inlined_subroutine || tag == DW_TAG_entry_point ||
+        tag == DW_TAG_label)
+      return skipDIE(currentDieType, debugInfo, end);
+  }
 
-  const Abbrev &currentDieType = abbrevTable[abbrevCode];
+  size_t dieIndex = dwarf.debugInfo.size();
   auto &die = dwarf.debugInfo.emplace_back();
 
   if (parentDIEs.size()) {
-    uint64_t parentOffset = parentDIEs.top();
-    DWARF::DIE *parentDie = dwarf.getDIEFromOffset(parentOffset);
-    assert(parentDie && "parent wasn't found, messed up somewhere");
-    parentDie->childrenOffsets.emplace_back(offset);
+    ParentDIE &parent = parentDIEs.top();
+    if (parent.lastChild)
+      dwarf.debugInfo[parent.lastChild].siblingDelta =
+          static_cast<uint32_t>(dieIndex - parent.lastChild);
+    else
+      dwarf.debugInfo[parent.index].hasChildren = true;
+    parent.lastChild = dieIndex;
   }
 
-  if (currentDieType.children)
-    parentDIEs.push(offset);
-
   die.tag = currentDieType.tag;
   die.offset = offset;
+  die.hasChildren = false;
+  die.siblingDelta = 0;
 
-  // TODO check if we would have read past end
-  for (const auto &[attr, form] : currentDieType.attributes)
-    die.info.emplace_back(attr, readFromPointer(form.type, debugInfo));
+  size_t numAttrs = currentDieType.attributes.size();
+  auto *attrs = dwarf.attributeArena.allocate<DWARF::Attribute>(numAttrs);
+  if (currentDieType.fixedSize) {
+    if (static_cast<size_t>(end - debugInfo) < *currentDieType.fixedSize)
+      return Error::malformed(
+          "Malformed DWARF: DIE at offset '{}' goes past the end of its unit",
+          offset);
+    const uint8_t *ptr = debugInfo;
+    for (size_t i = 0; i < numAttrs; i++) {
+      const AttributeSpec &spec = currentDieType.attributes[i];
+      attrs[i] = {spec.attr, spec.isString, spec.isSignature,
+                  readAttribute(spec, ptr)};
+    }
+    debugInfo += *currentDieType.fixedSize;
+  } else {
+    // TODO check if we would have read past end
+    for (size_t i = 0; i < numAttrs; i++) {
+      const AttributeSpec &spec = currentDieType.attributes[i];
+      attrs[i] = {spec.attr, spec.isString, spec.isSignature,
+                  readAttribute(spec, debugInfo)};
+    }
+  }
+  die.attrs = attrs;
+  die.numAttrs = static_cast<uint16_t>(numAttrs);
 
-  // End of child mark
-  if (parentDIEs.size() && !*debugInfo) {
-    debugInfo++;
-    parentDIEs.pop();
+  // Before DWARF 5 static data members are declared with DW_TAG_member.
+  if (die.tag == DW_TAG_variable ||
+      (die.tag == DW_TAG_member &&
+       die.getAttributeIfPresent(DW_AT_declaration)))
+    indexVariable(dieIndex);
+
+  if (currentDieType.children) {
+    std::string prefix = scopePrefixes.size() ? scopePrefixes.top() : "";
+    if (die.tag == DW_TAG_namespace || die.tag == DW_TAG_structure_type ||
+        die.tag == DW_TAG_class_type || die.tag == DW_TAG_union_type)
+      if (auto name = die.getAttributeIfPresent(DW_AT_name))
+        prefix.append(std::get<std::string_view>(*name)).append("::");
+    parentDIEs.push(dieIndex);
+    scopePrefixes.push(std::move(prefix));
   }
 
   return {};
 }
 
-ErrorOr<DWARF> DWARF::readFromObject(const ObjectFileReader &objectFileReader) {
-  if (const ELF::Reader *elfReader =
-          dynamic_cast<const ELF::Reader *>(&objectFileReader))
-    return DWARFReader::readFromELFObject(*elfReader);
-  return "Cannot get debug info from unkown objectFileReaderType"s;
+uint64_t DWARFReader::skipAttributes(const Abbrev &abbrev,
+                                     const uint8_t *&debugInfo) {
+  if (abbrev.fixedSize && !abbrev.hasSibling) {
+    debugInfo += *abbrev.fixedSize;
+    return 0;
+  }
+
+  uint64_t sibling = 0;
+  for (const SkipStep &step : abbrev.skipSteps) {
+    debugInfo += step.fixedSize;
+    skipLEB128s(debugInfo, step.numLEB128s);
+    if (step.index == SkipStep::noAttribute)
+      continue;
+    const AttributeSpec &spec = abbrev.attributes[step.index];
+    if (spec.attr == DW_AT_sibling)
+      // Read as a .debug_info offset.
+      sibling = readAttribute(spec, debugInfo);
+    else
+      skipAttribute(spec, debugInfo);
+  }
+  return sibling;
+}
+
+Error DWARFReader::skipDIE(const Abbrev &abbrev, const uint8_t *&debugInfo,
+                           const uint8_t *end) {
+  const Abbrev *current = &abbrev;
+  // Number of end of child marks still to be read.
+  size_t depth = 0;
+  for (;;) {
+    const uint8_t *dieStart = debugInfo;
+    uint64_t sibling = skipAttributes(*current, debugInfo);
+    if (current->children) {
+      // Without DW_AT_sibling the children have to be walked.
+      if (!sibling) {
+        depth++;
+      } else {
+        const uint8_t *next = debugInfoStart + (sibling - offsetBase);
+        if (next <= dieStart || next > end)
+          return Error::malformed(
+              "Malformed DWARF: DW_AT_sibling '{}' is out of bounds", sibling);
+        debugInfo = next;
+      }
+    }
+
+    uint64_t abbrevCode = 0;
+    while (depth) {
+      if (debugInfo >= end)
+        return Error::malformed("Malformed DWARF: expected another DIE but "
+                                "debug_info section has ended");
+      if ((abbrevCode = readULEB128(debugInfo)))
+        break;
+      depth--;
+    }
+    if (!depth)
+      return {};
+
+    current = abbrevTable->find(abbrevCode);
+    if (!current)
+      return Error::malformed(
+          "Malformed DWARF: Abbrev. Code '{}' isn't in the unit's abbrev table",
+          abbrevCode);
+  }
+}
+
+void DWARFReader::indexVariable(size_t dieIndex) {
+  const DWARF::DIE &die = dwarf.debugInfo[dieIndex];
+  bool isDeclaration = die.getAttributeIfPresent(DW_AT_declaration).has_value();
+
+  auto getName = [](const DWARF::DIE &die, DW_AT attr) -> std::string {
+    auto name = die.getAttributeIfPresent(attr);
+    return name ? std::string{std::get<std::string_view>(*name)}
+                : std::string{};
+  };
+
+  std::string name = getName(die, DW_AT_name);
+  std::string linkageName = getName(die, DW_AT_linkage_name);
+  std::string qualifiedName;
+
+  // Out of line definitions, like those of static data members, only point to
+  // their declaration which holds the names.
+  if (auto spec = die.getAttributeIfPresent(DW_AT_specification)) {
+    uint64_t specOffset = std::get<uint64_t>(*spec);
+    if (const DWARF::DIE *specDie = dwarf.getDIEFromOffset(specOffset)) {
+      if (name.empty())
+        name = getName(*specDie, DW_AT_name);
+      if (linkageName.empty())
+        linkageName = getName(*specDie, DW_AT_linkage_name);
+    }
+    if (auto it = declarationNames.find(specOffset);
+        it != declarationNames.end())
+      qualifiedName = it->second;
+  } else if (!name.empty()) {
+    qualifiedName = (scopePrefixes.size() ? scopePrefixes.top() : "") + name;
+  }
+
+  if (isDeclaration)
+    declarationNames.emplace(die.offset, qualifiedName);
+
+  for (std::string *key : {&name, &linkageName, &qualifiedName})
+    if (!key->empty())
+      addVariable(dwarf, std::move(*key), dieIndex, isDeclaration);
+}
+
+// Reads from the object's separate debug file if it has one, which the DWARF
+// then keeps open.
+static ErrorOr<DWARF>
+readFromObjectOrDebugFile(const ObjectFileReader &objectFileReader,
+                          const DebugFileOptions &debugFileOptions,
+                          DWARF::ParseMode mode,
+                          const std::vector<std::string_view> *names) {
+  const ELF::Reader *elfReader =
+      dynamic_cast<const ELF::Reader *>(&objectFileReader);
+  if (!elfReader)
+    return Error::unsupported(
+        "Cannot get debug info from unkown objectFileReaderType");
+  // Most objects have their own debug info, so only look for a separate file
+  // when this one doesn't.
+  std::optional<ErrorOr<DWARF>> ownDWARF;
+  if (debugFileOptions.debugFile.empty()) {
+    ownDWARF.emplace(DWARFReader::readFromELFObject(*elfReader, mode, names,
+                                                    debugFileOptions));
+    if (*ownDWARF || elfReader->getSection(".debug_info"))
+      return std::move(*ownDWARF);
+  }
+
+  ErrorOr<std::unique_ptr<ObjectFileReader>> debugFileOrErr =
+      openDebugFile(objectFileReader, debugFileOptions);
+  if (!debugFileOrErr)
+    return debugFileOrErr.takeError();
+  if (!*debugFileOrErr)
+    return std::move(*ownDWARF);
+  std::shared_ptr<const ObjectFileReader> debugFile =
+      std::move(*debugFileOrErr);
+  elfReader = dynamic_cast<const ELF::Reader *>(debugFile.get());
+  if (!elfReader)
+    return Error::unsupported(
+        "Cannot get debug info from unkown objectFileReaderType");
+  ErrorOr<DWARF> dwarfOrErr =
+      DWARFReader::readFromELFObject(*elfReader, mode, names, debugFileOptions);
+  if (dwarfOrErr)
+    DWARFReader::addFile(*dwarfOrErr, std::move(debugFile));
+  return dwarfOrErr;
+}
+
+ErrorOr<DWARF> DWARF::readFromObject(const ObjectFileReader &objectFileReader,
+                                     ParseMode mode,
+                                     const DebugFileOptions &debugFileOptions) {
+  return readFromObjectOrDebugFile(objectFileReader, debugFileOptions, mode,
+                                   nullptr);
+}
+
+ErrorOr<DWARF> DWARF::readFromObject(const ObjectFileReader &objectFileReader,
+                                     const std::vector<std::string_view> &names,
+                                     ParseMode mode,
+                                     const DebugFileOptions &debugFileOptions) {
+  return readFromObjectOrDebugFile(objectFileReader, debugFileOptions, mode,
+                                   &names);
 }
@@ -0,0 +1,415 @@
+// Copyright 2021 Alex Brachet (alex@brachet.dev)
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <unordered_map>
+#include <utility>
+
+#include "cedo/Binfmt/DWARF.h"
+#include "cedo/Binfmt/DWARFConstants.h"
+#include "cedo/Core/LEB128.h"
+
+#include "DWARFNameIndex.h"
+
+namespace {
+
+using Units = std::vector<uint64_t>;
+using Names = std::vector<std::string_view>;
+
+template <typename T> T read(const uint8_t *&ptr) {
+  T t;
+  std::memcpy(&t, ptr, sizeof(T));
+  ptr += sizeof(T);
+  return t;
+}
+
+uint64_t readOffset(const uint8_t *&ptr, bool is64) {
+  return is64 ? read<uint64_t>(ptr) : read<uint32_t>(ptr);
+}
+
+// Reads a unit's initial length and returns the end of the unit, or nullptr
+// if it doesn't fit in the section.
+const uint8_t *readInitialLength(const uint8_t *&ptr, const uint8_t *end,
+                                 bool &is64) {
+  if (end - ptr < 4)
+    return nullptr;
+  uint64_t length = read<uint32_t>(ptr);
+  is64 = length == 0xffffffff;
+  if (is64) {
+    if (end - ptr < 8)
+      return nullptr;
+    length = read<uint64_t>(ptr);
+  } else if (length >= 0xfffffff0) {
+    return nullptr;
+  }
+  return length <= static_cast<uint64_t>(end - ptr) ? ptr + length : nullptr;
+}
+
+// Offsets in relocatable objects are left as 0 and filled in by relocations.
+uint64_t resolveOffset(const ELF::Reader &elfReader, const char *secName,
+                       ELF::Section sec, const uint8_t *ptr, uint64_t offset,
+                       ELF::Section target) {
+  if (offset)
+    return offset;
+  if (ErrorOr<const uint8_t *> resolved =
+          elfReader.attemptResolveLocalReloc(secName, ptr - sec.data))
+    return *resolved - target.data;
+  return offset;
+}
+
+// The findIn* functions add the units defining each name to units. They return
+// false if the index is malformed or doesn't have every name.
+
+// .debug_pubnames and .debug_gnu_pubnames are a list of sets, one per unit,
+// of (DIE offset, name) pairs. There's no hash table, so every set is
+// scanned.
+bool findInPubnames(const ELF::Reader &elfReader, const char *secName,
+                    ELF::Section pubnames, ELF::Section debugInfo,
+                    const Names &names, Units &units) {
+  std::vector<bool> found(names.size());
+  const uint8_t *const end = pubnames.data + pubnames.size;
+  bool isGNU = std::string_view{secName} == ".debug_gnu_pubnames";
+  for (const uint8_t *ptr = pubnames.data; ptr < end;) {
+    bool is64;
+    const uint8_t *setEnd = readInitialLength(ptr, end, is64);
+    size_t offsetSize = is64 ? 8 : 4;
+    if (!setEnd || static_cast<size_t>(setEnd - ptr) < 2 + 2 * offsetSize)
+      return false;
+    if (read<uint16_t>(ptr) != 2)
+      return false;
+    const uint8_t *unitOffsetPtr = ptr;
+    uint64_t unitOffset =
+        resolveOffset(elfReader, secName, pubnames, unitOffsetPtr,
+                      readOffset(ptr, is64), debugInfo);
+    readOffset(ptr, is64);
+
+    while (static_cast<size_t>(setEnd - ptr) >= offsetSize) {
+      if (!readOffset(ptr, is64))
+        break;
+      if (isGNU)
+        ptr++;
+      if (ptr >= setEnd)
+        return false;
+      const char *str = reinterpret_cast<const char *>(ptr);
+      std::string_view name{str, strnlen(str, setEnd - ptr)};
+      ptr += name.size() + 1;
+      for (size_t i = 0; i < names.size(); i++)
+        if (names[i] == name) {
+          found[i] = true;
+          units.push_back(unitOffset);
+        }
+    }
+    ptr = setEnd;
+  }
+  return std::all_of(found.begin(), found.end(), [](bool b) { return b; });
+}
+
+uint32_t gdbIndexHash(std::string_view name) {
+  uint32_t hash = 0;
+  for (unsigned char c : name)
+    hash = hash * 67 + std::tolower(c) - 113;
+  return hash;
+}
+
+// .gdb_index is an open addressed hash table of names, each pointing to the
+// list of units defining it.
+bool findInGdbIndex(ELF::Section gdbIndex, const Names &names, Units &units) {
+  const uint8_t *ptr = gdbIndex.data;
+  if (gdbIndex.size < 6 * 4)
+    return false;
+  uint32_t version = read<uint32_t>(ptr);
+  uint32_t cuListOffset = read<uint32_t>(ptr);
+  uint32_t tuListOffset = read<uint32_t>(ptr);
+  read<uint32_t>(ptr);
+  uint32_t symbolTableOffset = read<uint32_t>(ptr);
+  uint32_t constantPoolOffset = read<uint32_t>(ptr);
+  // Older versions hash names differently.
+  if (version < 5 || version > 8)
+    return false;
+  if (cuListOffset > tuListOffset || symbolTableOffset > constantPoolOffset ||
+      constantPoolOffset > gdbIndex.size)
+    return false;
+
+  size_t numUnits = (tuListOffset - cuListOffset) / 16;
+  size_t numSlots = (constantPoolOffset - symbolTableOffset) / 8;
+  if (!numSlots || (numSlots & (numSlots - 1)))
+    return false;
+  const uint8_t *symbolTable = gdbIndex.data + symbolTableOffset;
+  const uint8_t *pool = gdbIndex.data + constantPoolOffset;
+  size_t poolSize = gdbIndex.size - constantPoolOffset;
+
+  for (std::string_view name : names) {
+    uint32_t hash = gdbIndexHash(name);
+    size_t slot = hash & (numSlots - 1);
+    size_t step = ((hash * 17) & (numSlots - 1)) | 1;
+    bool found = false;
+    for (size_t probes = 0; probes < numSlots && !found; probes++) {
+      const uint8_t *slotPtr = symbolTable + slot * 8;
+      uint32_t nameOffset = read<uint32_t>(slotPtr);
+      uint32_t vectorOffset = read<uint32_t>(slotPtr);
+      if (!nameOffset && !vectorOffset)
+        break;
+      slot = (slot + step) & (numSlots - 1);
+      if (nameOffset >= poolSize || vectorOffset + 4ul > poolSize)
+        return false;
+      const char *slotName = reinterpret_cast<const char *>(pool + nameOffset);
+      if (std::string_view{slotName,
+                           strnlen(slotName, poolSize - nameOffset)} != name)
+        continue;
+
+      const uint8_t *vec = pool + vectorOffset;
+      uint32_t numEntries = read<uint32_t>(vec);
+      if (numEntries > (poolSize - vectorOffset - 4) / 4)
+        return false;
+      for (uint32_t i = 0; i < numEntries; i++) {
+        uint32_t entry = read<uint32_t>(vec);
+        size_t unit = entry & 0xffffff;
+        // Only variables, or entries which don't say what they are.
+        unsigned kind = (entry >> 28) & 7;
+        if (version >= 7 && kind != 0 && kind != 2)
+          continue;
+        // Type units are numbered after the compile units.
+        if (unit >= numUnits)
+          continue;
+        const uint8_t *unitPtr = gdbIndex.data + cuListOffset + unit * 16;
+        units.push_back(read<uint64_t>(unitPtr));
+        found = true;
+      }
+    }
+    if (!found)
+      return false;
+  }
+  return true;
+}
+
+// DJB hash of the case folded name.
+uint32_t debugNamesHash(std::string_view name) {
+  uint32_t hash = 5381;
+  for (unsigned char c : name)
+    hash = hash * 33 + std::tolower(c);
+  return hash;
+}
+
+// Reads a DW_IDX_* value, returns false for forms whose size isn't known.
+bool readIndexValue(DW_FORM form, bool is64, const uint8_t *&ptr,
+                    const uint8_t *end, uint64_t &value) {
+  if (ptr >= end)
+    return false;
+  if (form == DW_FORM_udata || form == DW_FORM_ref_udata) {
+    value = readULEB128(ptr);
+    return ptr <= end;
+  }
+  if (form == DW_FORM_sdata) {
+    value = readSLEB128(ptr);
+    return ptr <= end;
+  }
+  size_t size = static_cast<size_t>(form.type);
+  if (form.type == DWARFType::DWARFAddr)
+    size = is64 ? 8 : 4;
+  else if (size > 8)
+    return false;
+  if (static_cast<size_t>(end - ptr) < size)
+    return false;
+  value = 0;
+  std::memcpy(&value, ptr, size);
+  ptr += size;
+  return true;
+}
+
+// .debug_names has a hash table per name index, each name points to a list
+// of entries in an abbreviated format like DIEs.
+bool findInDebugNames(const ELF::Reader &elfReader, ELF::Section debugNames,
+                      ELF::Section debugInfo, const Names &names,
+                      Units &units) {
+  ELF::Section debugStr = elfReader.getSection(".debug_str");
+  if (!debugStr)
+    return false;
+  std::vector<bool> found(names.size());
+  const uint8_t *const secEnd = debugNames.data + debugNames.size;
+
+  for (const uint8_t *ptr = debugNames.data; ptr < secEnd;) {
+    bool is64;
+    const uint8_t *end = readInitialLength(ptr, secEnd, is64);
+    size_t offsetSize = is64 ? 8 : 4;
+    if (!end || end - ptr < 4 + 7 * 4)
+      return false;
+    uint16_t version = read<uint16_t>(ptr);
+    read<uint16_t>(ptr);
+    if (version != 5)
+      return false;
+    uint32_t cuCount = read<uint32_t>(ptr);
+    uint32_t localTUCount = read<uint32_t>(ptr);
+    uint32_t foreignTUCount = read<uint32_t>(ptr);
+    uint32_t bucketCount = read<uint32_t>(ptr);
+    uint32_t nameCount = read<uint32_t>(ptr);
+    uint32_t abbrevTableSize = read<uint32_t>(ptr);
+    uint32_t augmentationSize = read<uint32_t>(ptr);
+
+    uint64_t tablesSize =
+        (augmentationSize + 3ul) / 4 * 4 + uint64_t{cuCount} * offsetSize +
+        uint64_t{localTUCount} * offsetSize + uint64_t{foreignTUCount} * 8 +
+        uint64_t{bucketCount} * 4 + (bucketCount ? nameCount * 4ul : 0) +
+        nameCount * 2ul * offsetSize + abbrevTableSize;
+    if (tablesSize > static_cast<uint64_t>(end - ptr))
+      return false;
+    ptr += (augmentationSize + 3ul) / 4 * 4;
+    const uint8_t *cuList = ptr;
+    ptr += cuCount * offsetSize + localTUCount * offsetSize +
+           foreignTUCount * 8ul;
+    const uint8_t *buckets = ptr;
+    ptr += bucketCount * 4ul;
+    const uint8_t *hashes = ptr;
+    if (bucketCount)
+      ptr += nameCount * 4ul;
+    const uint8_t *stringOffsets = ptr;
+    ptr += nameCount * offsetSize;
+    const uint8_t *entryOffsets = ptr;
+    ptr += nameCount * offsetSize;
+    const uint8_t *abbrevs = ptr;
+    const uint8_t *entryPool = ptr += abbrevTableSize;
+
+    // Abbrev code to its (DW_IDX, form) pairs.
+    std::unordered_map<uint64_t, std::vector<std::pair<uint64_t, DW_FORM>>>
+        abbrevTable;
+    for (const uint8_t *abbrev = abbrevs; abbrev < entryPool;) {
+      uint64_t code = readULEB128(abbrev);
+      if (!code)
+        break;
+      auto &attrs = abbrevTable[code];
+      skipLEB128(abbrev);
+      for (;;) {
+        if (abbrev >= entryPool)
+          return false;
+        uint64_t idx = readULEB128(abbrev);
+        uint64_t form = readULEB128(abbrev);
+        if (!idx && !form)
+          break;
+        if (!is_DW_FORM(form))
+          return false;
+        attrs.emplace_back(idx, get_DW_FORM(form));
+      }
+    }
+
+    auto readUnit = [&](size_t i) {
+      const uint8_t *unitPtr = cuList + i * offsetSize;
+      uint64_t offset = readOffset(unitPtr, is64);
+      return resolveOffset(elfReader, ".debug_names", debugNames,
+                           cuList + i * offsetSize, offset, debugInfo);
+    };
+
+    // Adds the units of every entry for the name at index i (1 based).
+    auto addEntries = [&](size_t i) {
+      const uint8_t *entryOffsetPtr = entryOffsets + (i - 1) * offsetSize;
+      uint64_t entryOffset = readOffset(entryOffsetPtr, is64);
+      if (entryOffset >= static_cast<uint64_t>(end - entryPool))
+        return false;
+      bool added = false;
+      for (const uint8_t *entry = entryPool + entryOffset; entry < end;) {
+        uint64_t code = readULEB128(entry);
+        if (!code)
+          break;
+        auto it = abbrevTable.find(code);
+        if (it == abbrevTable.end())
+          return false;
+        // Indexes with a single unit can leave it out.
+        std::optional<uint64_t> unit;
+        if (cuCount == 1)
+          unit = 0;
+        bool isTypeUnit = false;
+        for (auto [idx, form] : it->second) {
+          uint64_t value;
+          if (!readIndexValue(form, is64, entry, end, value))
+            return false;
+          if (idx == 1)
+            unit = value;
+          else if (idx == 2)
+            isTypeUnit = true;
+        }
+        if (isTypeUnit || !unit || *unit >= cuCount)
+          continue;
+        units.push_back(readUnit(*unit));
+        added = true;
+      }
+      return added;
+    };
+
+    auto nameAt = [&](size_t i) -> std::string_view {
+      const uint8_t *offsetPtr = stringOffsets + (i - 1) * offsetSize;
+      uint64_t offset = readOffset(offsetPtr, is64);
+      offset = resolveOffset(elfReader, ".debug_names", debugNames,
+                             stringOffsets + (i - 1) * offsetSize, offset,
+                             debugStr);
+      if (offset >= debugStr.size)
+        return {};
+      const char *str = reinterpret_cast<const char *>(debugStr.data + offset);
+      return {str, strnlen(str, debugStr.size - offset)};
+    };
+
+    // Names in .debug_names aren't qualified, "ns::table" is looked up as
+    // "table" and the parsed units are left to sort out which one it is.
+    for (size_t n = 0; n < names.size(); n++) {
+      std::string_view name = names[n];
+      if (size_t pos = name.rfind("::"); pos != std::string_view::npos)
+        name = name.substr(pos + 2);
+
+      if (!bucketCount) {
+        for (size_t i = 1; i <= nameCount; i++)
+          if (nameAt(i) == name && addEntries(i))
+            found[n] = true;
+        continue;
+      }
+
+      uint32_t hash = debugNamesHash(name);
+      const uint8_t *bucketPtr = buckets + hash % bucketCount * 4;
+      for (size_t i = read<uint32_t>(bucketPtr); i && i <= nameCount; i++) {
+        const uint8_t *hashPtr = hashes + (i - 1) * 4;
+        uint32_t nameHash = read<uint32_t>(hashPtr);
+        if (nameHash % bucketCount != hash % bucketCount)
+          break;
+        if (nameHash == hash && nameAt(i) == name && addEntries(i))
+          found[n] = true;
+      }
+    }
+    ptr = end;
+  }
+  return std::all_of(found.begin(), found.end(), [](bool b) { return b; });
+}
+
+} // namespace
+
+std::optional<std::vector<uint64_t>>
+DWARFNameIndex::findUnits(const ELF::Reader &elfReader, const Names &names) {
+  ELF::Section debugInfo = elfReader.getSection(".debug_info");
+  if (!debugInfo || names.empty())
+    return {};
+
+  Units units;
+  bool found = false;
+  if (ELF::Section debugNames = elfReader.getSection(".debug_names"))
+    found = findInDebugNames(elfReader, debugNames, debugInfo, names, units);
+  else if (ELF::Section gdbIndex = elfReader.getSection(".gdb_index"))
+    found = findInGdbIndex(gdbIndex, names, units);
+  else if (ELF::Section pubnames =
+               elfReader.getSection(".debug_gnu_pubnames"))
+    found = findInPubnames(elfReader, ".debug_gnu_pubnames", pubnames,
+                           debugInfo, names, units);
+  else if (ELF::Section pubnames = elfReader.getSection(".debug_pubnames"))
+    found = findInPubnames(elfReader, ".debug_pubnames", pubnames, debugInfo,
+                           names, units);
+  if (!found)
+    return {};
+
+  std::sort(units.begin(), units.end());
+  units.erase(std::unique(units.begin(), units.end()), units.end());
+  return units;
+}
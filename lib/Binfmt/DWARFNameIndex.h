@@ -0,0 +1,35 @@
+// Copyright 2021 Alex Brachet (alex@brachet.dev)
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CEDO_LIB_BINFMT_DWARFNAMEINDEX_H
+#define CEDO_LIB_BINFMT_DWARFNAMEINDEX_H
+
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+#include "ELF.h"
+
+namespace DWARFNameIndex {
+
+// Uses the first name index the object has out of .debug_names, .gdb_index,
+// .debug_gnu_pubnames and .debug_pubnames to find which units define names.
+// Returns the sorted .debug_info offsets of those units, or nothing if there
+// is no usable index or one of the names isn't in it. In that case every unit
+// has to be read.
+std::optional<std::vector<uint64_t>>
+findUnits(const ELF::Reader &elfReader,
+          const std::vector<std::string_view> &names);
+
+} // namespace DWARFNameIndex
+
+#endif // CEDO_LIB_BINFMT_DWARFNAMEINDEX_H
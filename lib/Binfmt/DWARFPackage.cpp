@@ -0,0 +1,93 @@
+// Copyright 2021 Alex Brachet (alex@brachet.dev)
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstring>
+
+#include "DWARFPackage.h"
+
+namespace DWARFPackage {
+
+// Column identifiers, these are the same in version 2 and 5.
+static constexpr uint32_t DW_SECT_INFO = 1;
+static constexpr uint32_t DW_SECT_ABBREV = 3;
+static constexpr uint32_t DW_SECT_STR_OFFSETS = 6;
+
+template <typename T> static T read(const uint8_t *ptr) {
+  T value;
+  std::memcpy(&value, ptr, sizeof(T));
+  return value;
+}
+
+std::optional<UnitContribution> findUnit(ELF::Section cuIndex, uint64_t dwoID) {
+  // The version, 2 as a uint32 or 5 as a uint16 and padding, then the number
+  // of columns, units and hash table slots.
+  if (cuIndex.size < 16)
+    return {};
+  uint16_t version = read<uint16_t>(cuIndex.data);
+  if (version != 2 && version != 5)
+    return {};
+  uint32_t numColumns = read<uint32_t>(cuIndex.data + 4);
+  uint32_t numUnits = read<uint32_t>(cuIndex.data + 8);
+  uint32_t numSlots = read<uint32_t>(cuIndex.data + 12);
+  // The number of slots is a power of two greater than the number of units.
+  if (!numSlots || numSlots & (numSlots - 1) || numUnits >= numSlots)
+    return {};
+
+  // The hash table's signatures then row indices, then a row of column
+  // identifiers, and the tables of offsets and sizes.
+  uint64_t tableSize = uint64_t{numSlots} * 12 + uint64_t{numColumns} * 4 +
+                       uint64_t{numUnits} * numColumns * 8;
+  if (tableSize > cuIndex.size - 16)
+    return {};
+  const uint8_t *signatures = cuIndex.data + 16;
+  const uint8_t *rows = signatures + uint64_t{numSlots} * 8;
+  const uint8_t *columns = rows + uint64_t{numSlots} * 4;
+  const uint8_t *offsets = columns + uint64_t{numColumns} * 4;
+  const uint8_t *sizes = offsets + uint64_t{numUnits} * numColumns * 4;
+
+  uint32_t mask = numSlots - 1;
+  uint32_t slot = dwoID & mask;
+  uint32_t step = ((dwoID >> 32) & mask) | 1;
+  uint32_t row = 0;
+  for (uint32_t i = 0; i < numSlots; i++, slot = (slot + step) & mask) {
+    row = read<uint32_t>(rows + slot * 4);
+    if (!row || read<uint64_t>(signatures + slot * 8) == dwoID)
+      break;
+  }
+  if (!row || row > numUnits ||
+      read<uint64_t>(signatures + slot * 8) != dwoID)
+    return {};
+
+  UnitContribution unit;
+  bool hasInfo = false;
+  for (uint32_t column = 0; column < numColumns; column++) {
+    uint64_t index = (uint64_t{row} - 1) * numColumns + column;
+    uint32_t offset = read<uint32_t>(offsets + index * 4);
+    switch (read<uint32_t>(columns + column * 4)) {
+    case DW_SECT_INFO:
+      hasInfo = true;
+      unit.infoOffset = offset;
+      unit.infoSize = read<uint32_t>(sizes + index * 4);
+      break;
+    case DW_SECT_ABBREV:
+      unit.abbrevOffset = offset;
+      break;
+    case DW_SECT_STR_OFFSETS:
+      unit.strOffsetsOffset = offset;
+      break;
+    }
+  }
+  if (!hasInfo)
+    return {};
+  return unit;
+}
+
+} // namespace DWARFPackage
@@ -0,0 +1,37 @@
+// Copyright 2021 Alex Brachet (alex@brachet.dev)
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CEDO_LIB_BINFMT_DWARFPACKAGE_H
+#define CEDO_LIB_BINFMT_DWARFPACKAGE_H
+
+#include <cstdint>
+#include <optional>
+
+#include "ELF.h"
+
+namespace DWARFPackage {
+
+// Where one split unit's pieces are in a .dwp's sections. In a .dwo the unit
+// has each section to itself.
+struct UnitContribution {
+  uint64_t infoOffset = 0;
+  uint64_t infoSize = 0;
+  uint64_t abbrevOffset = 0;
+  uint64_t strOffsetsOffset = 0;
+};
+
+// Looks up the unit with dwoID in a .dwp's .debug_cu_index, version 2 from
+// the GNU extension or version 5.
+std::optional<UnitContribution> findUnit(ELF::Section cuIndex, uint64_t dwoID);
+
+} // namespace DWARFPackage
+
+#endif // CEDO_LIB_BINFMT_DWARFPACKAGE_H
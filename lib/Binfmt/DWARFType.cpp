@@ -18,45 +18,57 @@
 #include "cedo/Binfmt/DWARFConstants.h"
 #include "cedo/Binfmt/Type.h"
 
+const DWARF::Attribute *DWARF::DIE::findAttribute(DW_AT attr) const {
+  const Attribute *end = attrs + numAttrs;
+  const Attribute *it = std::find_if(
+      attrs, end, [attr](const Attribute &a) { return a.attr == attr; });
+  return it == end ? nullptr : it;
+}
+
 std::optional<DWARF::Data> DWARF::DIE::getAttributeIfPresent(DW_AT attr) const {
-  auto it = std::find_if(info.begin(), info.end(),
-                         [attr](const auto &i) { return i.first == attr; });
-  if (it == info.end())
-    return {};
-  return it->second;
+  if (const Attribute *attribute = findAttribute(attr))
+    return attribute->getData();
+  return {};
 }
 
 const DWARF::DIE *DWARF::getTypeDieFromDie(const DIE &die) const {
-  auto typeOffsetOrErr = die.getAttributeIfPresent(DW_AT_type);
-  if (!typeOffsetOrErr)
+  const Attribute *type = die.findAttribute(DW_AT_type);
+  if (!type)
     return nullptr;
-  return getDIEFromOffset(std::get<uint64_t>(*typeOffsetOrErr));
+  const DIE *typeDie = type->isSignature ? getTypeUnitDIE(type->value)
+                                          : getDIEFromOffset(type->value);
+  // Types defined in type units are usually referred to through a declaration
+  // in the unit that names the type unit.
+  if (typeDie)
+    if (const Attribute *signature = typeDie->findAttribute(DW_AT_signature);
+        signature && signature->isSignature)
+      return getTypeUnitDIE(signature->value);
+  return typeDie;
 }
 
-std::unique_ptr<Type> DWARF::getTypeFromBaseTypeDie(const DIE &die) const {
+const Type *DWARF::getTypeFromBaseTypeDie(const DIE &die) const {
   assert(die.tag == DW_TAG_base_type);
 
   auto attrOrErr = die.getAttributeIfPresent(DW_AT_byte_size);
   if (!attrOrErr)
     return nullptr;
 
-  return std::make_unique<BaseType>(0, std::get<uint64_t>(*attrOrErr));
+  return typeGraph->create<BaseType>(0, std::get<uint64_t>(*attrOrErr));
 }
 
-std::unique_ptr<Type> DWARF::getTypeFromArrayDie(const DIE &die) const {
+const Type *DWARF::getTypeFromArrayDie(const DIE &die) const {
   assert(die.tag == DW_TAG_array_type);
 
   const DIE *typeDie = getTypeDieFromDie(die);
   if (!typeDie)
     return nullptr;
-  std::unique_ptr<Type> elementType = getTypeFromTypeDie(*typeDie);
+  const Type *elementType = getTypeFromTypeDie(*typeDie);
   if (!elementType)
     return nullptr;
 
-  uint64_t firstChildOffset = die.childrenOffsets[0];
-  const DIE *subrangeDie = getDIEFromOffset(firstChildOffset);
-  if (!subrangeDie)
-    return 0;
+  if (!die.hasChildren)
+    return nullptr;
+  const DIE *subrangeDie = &*die.children().begin();
 
   // TOOD read the standard more here...
   assert(subrangeDie->tag == DW_TAG_subrange_type &&
@@ -66,36 +78,57 @@ std::unique_ptr<Type> DWARF::getTypeFromArrayDie(const DIE &die) const {
   if (!numElements)
     return nullptr;
 
-  return std::make_unique<ArrayType>(0, std::move(elementType),
-                                     std::get<uint64_t>(*numElements));
+  return typeGraph->create<ArrayType>(0, elementType,
+                                      std::get<uint64_t>(*numElements));
 }
 
-std::unique_ptr<Type> DWARF::getTypeFromStructTypeDie(const DIE &die) const {
+const Type *DWARF::getTypeFromStructTypeDie(const DIE &die) const {
   auto byteSize = die.getAttributeIfPresent(DW_AT_byte_size);
   if (!byteSize)
     return nullptr;
 
-  std::unique_ptr<StructType> structType =
-      std::make_unique<StructType>(0, std::get<uint64_t>(*byteSize));
+  StructType *structType =
+      typeGraph->create<StructType>(0, std::get<uint64_t>(*byteSize));
   std::vector<StructType::Member> &members = structType->members;
+  // Cached before the members are resolved so pointers in them back to this
+  // struct find it.
+  typeCache[die.offset] = structType;
+  auto fail = [&]() -> const Type * {
+    typeCache.erase(die.offset);
+    return nullptr;
+  };
 
-  for (size_t childOffset : die.childrenOffsets) {
-    const DIE *child = getDIEFromOffset(childOffset);
+  for (const DIE &child : die.children()) {
     // TOOD maybe children could be something other than member. Look into the
     // standard...
-    if (!child || child->tag != DW_TAG_member)
-      return nullptr;
-
-    auto location = child->getAttributeIfPresent(DW_AT_data_member_location);
-    if (!location)
-      return nullptr;
+    if (child.tag != DW_TAG_member)
+      return fail();
 
-    const DIE *childTypeDie = getTypeDieFromDie(*child);
+    const DIE *childTypeDie = getTypeDieFromDie(child);
     if (!childTypeDie)
-      return nullptr;
-
-    members.emplace_back(getTypeFromTypeDie(*childTypeDie),
-                         std::get<uint64_t>(*location));
+      return fail();
+    const Type *childType = getTypeFromTypeDie(*childTypeDie);
+    // Emitting the struct without it would leave its bytes as padding.
+    if (!childType)
+      return fail();
+
+    uint64_t location;
+    if (auto memberLocation =
+            child.getAttributeIfPresent(DW_AT_data_member_location)) {
+      location = std::get<uint64_t>(*memberLocation);
+    } else if (auto bitOffset =
+                   child.getAttributeIfPresent(DW_AT_data_bit_offset)) {
+      // Bit fields since DWARF 4, placed at the start of the storage unit
+      // holding them like DW_AT_data_member_location does.
+      uint64_t unitSize = childType->getObjectSize();
+      if (!unitSize)
+        return fail();
+      location = std::get<uint64_t>(*bitOffset) / (unitSize * 8) * unitSize;
+    } else {
+      return fail();
+    }
+
+    members.emplace_back(childType, location);
   }
 
   std::sort(members.begin(), members.end(),
@@ -106,55 +139,94 @@ std::unique_ptr<Type> DWARF::getTypeFromStructTypeDie(const DIE &die) const {
   return structType;
 }
 
-std::unique_ptr<Type> DWARF::getTypeFromPointerTypeDie(const DIE &die) const {
-  const DWARF::DIE *pointingTypeDie = getTypeDieFromDie(die);
-  std::unique_ptr<Type> pointingType = getTypeFromTypeDie(*pointingTypeDie);
+const Type *DWARF::getTypeFromPointerTypeDie(const DIE &die) const {
   // TODO: find other qualifiers
-  return std::make_unique<PointerType>(Type::Qualifier::Pointer, std::move(pointingType));
+  PointerType *pointerType =
+      typeGraph->create<PointerType>(Type::Qualifier::Pointer, nullptr);
+  // Cycles in the type graph always go through a pointer, caching it before
+  // resolving what it points to is what ends them.
+  typeCache[die.offset] = pointerType;
+  if (const DWARF::DIE *pointingTypeDie = getTypeDieFromDie(die))
+    pointerType->pointingType = getTypeFromTypeDie(*pointingTypeDie);
+  return pointerType;
 }
 
-std::unique_ptr<Type> DWARF::getTypeFromTypeDie(const DIE &typeDie) const {
-  if (typeDie.tag == DW_TAG_typedef) {
+const Type *DWARF::getTypeFromTypeDie(const DIE &typeDie) const {
+  if (auto it = typeCache.find(typeDie.offset); it != typeCache.end())
+    return it->second;
+
+  const Type *type = nullptr;
+  switch (typeDie.tag) {
+  case DW_TAG_typedef: {
     const DWARF::DIE *realType = getTypeDieFromDie(typeDie);
     assert(realType &&
            "typedef DIE's DW_AT_type did not point to a valid type");
-    return getTypeFromTypeDie(*realType);
+    type = getTypeFromTypeDie(*realType);
+    break;
   }
-  switch (typeDie.tag) {
   case DW_TAG_base_type:
-    return getTypeFromBaseTypeDie(typeDie);
+    type = getTypeFromBaseTypeDie(typeDie);
+    break;
   case DW_TAG_structure_type:
   case DW_TAG_class_type:
   case DW_TAG_union_type:
     return getTypeFromStructTypeDie(typeDie);
   case DW_TAG_array_type:
-    return getTypeFromArrayDie(typeDie);
+    type = getTypeFromArrayDie(typeDie);
+    break;
   case DW_TAG_pointer_type:
     return getTypeFromPointerTypeDie(typeDie);
   default:
     assert(0 && "only base_type is currently supported");
   }
-  return nullptr;
+  if (type)
+    typeCache.emplace(typeDie.offset, type);
+  return type;
+}
+
+const DWARF::DIE *DWARF::findVariable(std::string_view sym_name) const {
+  auto it = variableIndex.find(std::string{sym_name});
+  if (it == variableIndex.end())
+    return nullptr;
+  return &debugInfo[it->second.dieIndex];
 }
 
-std::unique_ptr<Type> DWARF::getVariableType(std::string_view sym_name) const {
-  auto it = std::find_if(
-      debugInfo.begin(), debugInfo.end(), [sym_name](const DIE &die) {
-        if (die.tag != DW_TAG_variable)
-          return false;
+const Type *DWARF::getVariableType(std::string_view sym_name) const {
+  const DIE *die = findVariable(sym_name);
+  if (!die)
+    return nullptr;
 
-        auto attrOrError = die.getAttributeIfPresent(DW_AT_name);
-        if (!attrOrError)
-          return false;
+  const DIE *typeDie = getTypeDieFromDie(*die);
+  // Definitions which point to their declaration don't need to repeat its
+  // type.
+  if (!typeDie)
+    if (auto spec = die->getAttributeIfPresent(DW_AT_specification))
+      if (const DIE *specDie = getDIEFromOffset(std::get<uint64_t>(*spec)))
+        typeDie = getTypeDieFromDie(*specDie);
+  if (!typeDie)
+    return nullptr;
 
-        return std::get<std::string>(*attrOrError) == sym_name;
-      });
-  if (it == debugInfo.end())
+  return getTypeFromTypeDie(*typeDie);
+}
+
+std::string_view
+DWARF::getVariableLinkageName(std::string_view sym_name) const {
+  const DIE *die = findVariable(sym_name);
+  if (!die)
     return {};
 
-  const DIE *typeDie = getTypeDieFromDie(*it);
-  if (!typeDie)
+  auto findString = [this](const DIE *die, DW_AT attr) -> std::string_view {
+    while (die) {
+      if (auto name = die->getAttributeIfPresent(attr))
+        if (const auto *str = std::get_if<std::string_view>(&*name))
+          return *str;
+      auto spec = die->getAttributeIfPresent(DW_AT_specification);
+      die = spec ? getDIEFromOffset(std::get<uint64_t>(*spec)) : nullptr;
+    }
     return {};
+  };
 
-  return getTypeFromTypeDie(*typeDie);
+  if (std::string_view name = findString(die, DW_AT_linkage_name); name.size())
+    return name;
+  return findString(die, DW_AT_name);
 }
@@ -0,0 +1,196 @@
+// Copyright 2021 Alex Brachet (alex@brachet.dev)
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstdlib>
+#include <cstring>
+#include <string_view>
+
+#include "ELF.h"
+#include "cedo/Binfmt/DebugFile.h"
+#include "cedo/Core/LEB128.h"
+
+using namespace std::string_literals;
+
+// CRC-32 with the 0xEDB88320 polynomial, like zlib's crc32.
+static constexpr struct CRCTable {
+  uint32_t entries[256] = {};
+
+  constexpr CRCTable() {
+    for (uint32_t i = 0; i < 256; i++) {
+      uint32_t crc = i;
+      for (int bit = 0; bit < 8; bit++)
+        crc = crc & 1 ? (crc >> 1) ^ 0xedb88320 : crc >> 1;
+      entries[i] = crc;
+    }
+  }
+} crcTable;
+
+uint32_t debugLinkCRC32(const uint8_t *data, size_t size, uint32_t crc) {
+  crc = ~crc;
+  for (const uint8_t *end = data + size; data != end; data++)
+    crc = crcTable.entries[(crc ^ *data) & 0xff] ^ (crc >> 8);
+  return ~crc;
+}
+
+static std::unique_ptr<ObjectFileReader> open(const std::string &path) {
+  // Only the debug sections are read, so don't read in the whole file.
+  ErrorOr<FileReader> fileOrErr =
+      FileReader::open(path, FileReader::MapMode::Lazy);
+  if (!fileOrErr)
+    return nullptr;
+  return createObjectFileReader(std::move(*fileOrErr));
+}
+
+static uint32_t getFileCRC(const FileReader &file) {
+  const uint8_t *data = reinterpret_cast<const uint8_t *>(file.getFileBuffer());
+  file.willNeed(data, file.getFileSize());
+  uint32_t crc = debugLinkCRC32(data, file.getFileSize());
+  file.dontNeed(data, file.getFileSize());
+  return crc;
+}
+
+static std::unique_ptr<ObjectFileReader>
+findByBuildID(std::string_view buildID, const DebugFileOptions &options) {
+  static constexpr char hexDigits[] = "0123456789abcdef";
+  if (buildID.size() < 2)
+    return nullptr;
+  // .build-id/xx/yyyy.debug, where xx is the first byte.
+  std::string name = ".build-id/";
+  for (size_t i = 0; i < buildID.size(); i++) {
+    unsigned char c = buildID[i];
+    name += hexDigits[c >> 4];
+    name += hexDigits[c & 0xf];
+    if (!i)
+      name += '/';
+  }
+  name += ".debug";
+
+  for (const std::string &dir : options.debugDirs)
+    if (auto reader = open(dir + '/' + name);
+        reader && reader->getBuildID() == buildID)
+      return reader;
+  return nullptr;
+}
+
+static std::string getObjectDir(const DebugFileOptions &options) {
+  if (size_t slash = options.objectPath.rfind('/');
+      slash != std::string::npos)
+    return options.objectPath.substr(0, slash);
+  return ".";
+}
+
+static std::unique_ptr<ObjectFileReader>
+findByDebugLink(const ELF::Reader &elfReader, const DebugFileOptions &options) {
+  // A null terminated file name, padded to 4 bytes, then its CRC.
+  ELF::Section debugLink = elfReader.getSection(".gnu_debuglink");
+  if (!debugLink)
+    return nullptr;
+  const char *linkStart = reinterpret_cast<const char *>(debugLink.data);
+  size_t nameSize = strnlen(linkStart, debugLink.size);
+  size_t crcOffset = (nameSize + 4) & ~size_t{3};
+  if (!nameSize || crcOffset + 4 > debugLink.size)
+    return nullptr;
+  std::string name{linkStart, nameSize};
+  uint32_t crc;
+  std::memcpy(&crc, debugLink.data + crcOffset, sizeof(crc));
+
+  std::string objectDir = getObjectDir(options);
+  // The same places GDB looks.
+  std::vector<std::string> candidates = {objectDir + '/' + name,
+                                         objectDir + "/.debug/" + name};
+  if (char *absoluteDir = ::realpath(objectDir.c_str(), nullptr)) {
+    for (const std::string &dir : options.debugDirs)
+      candidates.push_back(dir + absoluteDir + '/' + name);
+    std::free(absoluteDir);
+  }
+
+  for (const std::string &path : candidates)
+    if (auto reader = open(path);
+        reader && getFileCRC(reader->getFileReader()) == crc)
+      return reader;
+  return nullptr;
+}
+
+ErrorOr<std::unique_ptr<ObjectFileReader>>
+openDebugFile(const ObjectFileReader &objectFileReader,
+              const DebugFileOptions &options) {
+  if (!options.debugFile.empty()) {
+    std::unique_ptr<ObjectFileReader> reader = open(options.debugFile);
+    if (!reader)
+      return "Couldn't read debug file \""s + options.debugFile + '"';
+    std::string_view buildID = objectFileReader.getBuildID();
+    if (!buildID.empty() && !reader->getBuildID().empty() &&
+        reader->getBuildID() != buildID)
+      return "Debug file \""s + options.debugFile +
+             "\" has a different build ID than the object";
+    return reader;
+  }
+
+  const auto *elfReader = dynamic_cast<const ELF::Reader *>(&objectFileReader);
+  if (!elfReader || elfReader->getSection(".debug_info"))
+    return nullptr;
+  if (auto reader = findByBuildID(objectFileReader.getBuildID(), options))
+    return reader;
+  return findByDebugLink(*elfReader, options);
+}
+
+ErrorOr<std::unique_ptr<ObjectFileReader>>
+openSupplementaryFile(const ObjectFileReader &objectFileReader,
+                      const DebugFileOptions &options) {
+  const auto *elfReader = dynamic_cast<const ELF::Reader *>(&objectFileReader);
+  if (!elfReader)
+    return nullptr;
+
+  // .gnu_debugaltlink is a null terminated file name followed by the file's
+  // build ID. DWARF 5's .debug_sup has a version and a flag before the name,
+  // and the ID after it has its size as a ULEB128.
+  std::string_view name;
+  std::string_view buildID;
+  if (ELF::Section altLink = elfReader->getSection(".gnu_debugaltlink")) {
+    const char *start = reinterpret_cast<const char *>(altLink.data);
+    size_t nameSize = strnlen(start, altLink.size);
+    if (nameSize == altLink.size)
+      return Error::malformed("Malformed .gnu_debugaltlink section");
+    name = {start, nameSize};
+    buildID = {start + nameSize + 1, altLink.size - nameSize - 1};
+  } else if (ELF::Section sup = elfReader->getSection(".debug_sup");
+             sup.size > 3) {
+    const char *start = reinterpret_cast<const char *>(sup.data + 3);
+    size_t nameSize = strnlen(start, sup.size - 3);
+    if (nameSize == sup.size - 3)
+      return Error::malformed("Malformed .debug_sup section");
+    name = {start, nameSize};
+    const uint8_t *ptr = sup.data + 3 + nameSize + 1;
+    const uint8_t *end = sup.data + sup.size;
+    uint64_t checksumSize = ptr < end ? readULEB128(ptr) : 0;
+    if (ptr <= end && checksumSize <= static_cast<uint64_t>(end - ptr))
+      buildID = {reinterpret_cast<const char *>(ptr), checksumSize};
+  } else {
+    return nullptr;
+  }
+  if (name.empty())
+    return nullptr;
+
+  auto matches = [&](const std::unique_ptr<ObjectFileReader> &reader) {
+    return reader && (buildID.empty() || reader->getBuildID() == buildID);
+  };
+  std::string path{name};
+  if (path.front() != '/')
+    path = getObjectDir(options) + '/' + path;
+  if (auto reader = open(path); matches(reader))
+    return reader;
+  if (!buildID.empty())
+    if (auto reader = findByBuildID(buildID, options))
+      return reader;
+  return Error("Couldn't find supplementary debug file \""s +
+                   std::string{name} + '"',
+               Error::Code::NotFound);
+}
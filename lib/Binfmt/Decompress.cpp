@@ -0,0 +1,169 @@
+// Copyright 2021 Alex Brachet (alex@brachet.dev)
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <thread>
+#include <vector>
+
+#ifdef CEDO_HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef CEDO_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#include "Decompress.h"
+
+bool Decompress::isSupported(Format format) {
+  switch (format) {
+  case Format::Zlib:
+#ifdef CEDO_HAVE_ZLIB
+    return true;
+#else
+    return false;
+#endif
+  case Format::Zstd:
+#ifdef CEDO_HAVE_ZSTD
+    return true;
+#else
+    return false;
+#endif
+  }
+  return false;
+}
+
+uint64_t Decompress::getMaxUncompressedSize(Format format, size_t inSize) {
+  switch (format) {
+  case Format::Zlib:
+    // A deflate block of repeated matches expands at most 1032 times.
+    return uint64_t{inSize} * 1032;
+  case Format::Zstd:
+    // An RLE block is 4 bytes for up to 128 KiB.
+    return uint64_t{inSize} * 32768;
+  }
+  return 0;
+}
+
+#ifdef CEDO_HAVE_ZLIB
+static Error decompressZlib(const uint8_t *in, size_t inSize, uint8_t *out,
+                            size_t outSize) {
+  z_stream stream{};
+  if (inflateInit(&stream) != Z_OK)
+    return Error(Error::Code::Other, "Couldn't initialize zlib");
+
+  // avail_in and avail_out are only 32 bits.
+  stream.next_in = const_cast<uint8_t *>(in);
+  stream.next_out = out;
+  int ret;
+  do {
+    size_t inLeft = in + inSize - stream.next_in;
+    size_t outLeft = out + outSize - stream.next_out;
+    stream.avail_in = std::min<size_t>(inLeft, UINT_MAX);
+    stream.avail_out = std::min<size_t>(outLeft, UINT_MAX);
+    ret = inflate(&stream, Z_NO_FLUSH);
+  } while (ret == Z_OK);
+  size_t written = stream.next_out - out;
+  inflateEnd(&stream);
+
+  if (ret != Z_STREAM_END || written != outSize)
+    return Error::malformed("Malformed zlib compressed section");
+  return {};
+}
+#endif
+
+#ifdef CEDO_HAVE_ZSTD
+static Error decompressZstd(const uint8_t *in, size_t inSize, uint8_t *out,
+                            size_t outSize) {
+  // Each frame records its own sizes, so they can be decompressed
+  // independently if the producer split the section into more than one.
+  struct Frame {
+    const uint8_t *in;
+    size_t inSize;
+    uint8_t *out;
+    size_t outSize;
+  };
+  std::vector<Frame> frames;
+  size_t outOffset = 0;
+  for (size_t inOffset = 0; inOffset < inSize;) {
+    size_t frameSize =
+        ZSTD_findFrameCompressedSize(in + inOffset, inSize - inOffset);
+    unsigned long long contentSize =
+        ZSTD_getFrameContentSize(in + inOffset, inSize - inOffset);
+    if (ZSTD_isError(frameSize) || contentSize == ZSTD_CONTENTSIZE_ERROR)
+      return Error::malformed("Malformed zstd compressed section");
+    // Without sizes the frames can't be placed, decompress it all at once.
+    if (contentSize == ZSTD_CONTENTSIZE_UNKNOWN ||
+        contentSize > outSize - outOffset) {
+      frames.clear();
+      break;
+    }
+    frames.push_back(
+        {in + inOffset, frameSize, out + outOffset, size_t(contentSize)});
+    inOffset += frameSize;
+    outOffset += contentSize;
+  }
+  if (outOffset != outSize)
+    frames.clear();
+
+  if (frames.size() <= 1) {
+    size_t ret = ZSTD_decompress(out, outSize, in, inSize);
+    if (ZSTD_isError(ret) || ret != outSize)
+      return Error::malformed("Malformed zstd compressed section");
+    return {};
+  }
+
+  std::atomic<size_t> nextFrame = 0;
+  std::atomic<bool> failed = false;
+  auto decompressFrames = [&] {
+    for (size_t i; (i = nextFrame++) < frames.size();) {
+      const Frame &frame = frames[i];
+      size_t ret =
+          ZSTD_decompress(frame.out, frame.outSize, frame.in, frame.inSize);
+      if (ZSTD_isError(ret) || ret != frame.outSize)
+        failed = true;
+    }
+  };
+  size_t numThreads = std::min<size_t>(
+      frames.size(), std::max(1u, std::thread::hardware_concurrency()));
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < numThreads; i++)
+    threads.emplace_back(decompressFrames);
+  decompressFrames();
+  for (std::thread &thread : threads)
+    thread.join();
+
+  if (failed)
+    return Error::malformed("Malformed zstd compressed section");
+  return {};
+}
+#endif
+
+Error Decompress::decompress(Format format, const uint8_t *in, size_t inSize,
+                             uint8_t *out, size_t outSize) {
+  switch (format) {
+  case Format::Zlib:
+#ifdef CEDO_HAVE_ZLIB
+    return decompressZlib(in, inSize, out, outSize);
+#else
+    break;
+#endif
+  case Format::Zstd:
+#ifdef CEDO_HAVE_ZSTD
+    return decompressZstd(in, inSize, out, outSize);
+#else
+    break;
+#endif
+  }
+  return Error::unsupported(
+      "cedo was built without support for this compression format");
+}
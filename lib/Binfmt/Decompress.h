@@ -0,0 +1,43 @@
+// Copyright 2021 Alex Brachet (alex@brachet.dev)
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CEDO_LIB_BINFMT_DECOMPRESS_H
+#define CEDO_LIB_BINFMT_DECOMPRESS_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "cedo/Core/Error.h"
+
+namespace Decompress {
+
+enum class Format {
+  Zlib,
+  Zstd,
+};
+
+// Whether cedo was built with the library for format.
+bool isSupported(Format format);
+
+// The most inSize bytes of format can decompress to. A larger uncompressed
+// size recorded for them is wrong.
+uint64_t getMaxUncompressedSize(Format format, size_t inSize);
+
+// Decompresses all of in into out, which must be exactly the uncompressed
+// size. Input that decompresses to any other size is malformed. zstd sections
+// made of more than one frame are decompressed in parallel, zlib streams can't
+// be split so they are always done in one go.
+Error decompress(Format format, const uint8_t *in, size_t inSize, uint8_t *out,
+                 size_t outSize);
+
+} // namespace Decompress
+
+#endif // CEDO_LIB_BINFMT_DECOMPRESS_H
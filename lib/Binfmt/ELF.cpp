@@ -14,19 +14,32 @@
 #include <algorithm>
 #include <cassert>
 #include <cstdint>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <new>
 #include <optional>
 #include <string_view>
+#include <tuple>
 #include <type_traits>
+#include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include "cedo/Binfmt/Binfmt.h"
 #include "cedo/Core/ErrorOr.h"
 #include "cedo/Core/FileReader.h"
 
+#include "Decompress.h"
 #include "ELF.h"
 
 using namespace std::string_literals;
 
+// Not in every elf.h yet.
+#ifndef ELFCOMPRESS_ZSTD
+#define ELFCOMPRESS_ZSTD 2
+#endif
+
 namespace ELF {
 
 std::optional<AddressSize> getAddressSize(uint8_t e) {
@@ -75,19 +88,43 @@ class ELFReaderImpl final : public Reader {
                                   Elf32_Rela>;
   using Sym =
       std::conditional_t<addrSize == AddressSize::Eight, Elf64_Sym, Elf32_Sym>;
-
-  template <typename RelType>
-  const RelType *getRelocForOffset(const Shdr &shdr, uint64_t offset) const {
-    uint64_t numRelocs = shdr.sh_size / sizeof(RelType);
-    const RelType *relocs =
-        reinterpret_cast<const RelType *>(getSectionAddr(shdr));
-
-    auto it =
-        std::find_if(relocs, relocs + numRelocs, [offset](const RelType &relo) {
-          return relo.r_offset == offset;
-        });
-    return it == relocs + numRelocs ? nullptr : it;
-  }
+  using Chdr = std::conditional_t<addrSize == AddressSize::Eight, Elf64_Chdr,
+                                  Elf32_Chdr>;
+
+  // One entry of a relocation section, with Rel's implicit addend already
+  // read out of the section being relocated.
+  struct Reloc {
+    uint64_t offset;
+    uint32_t type;
+    uint32_t sym;
+    int64_t addend;
+  };
+
+  // All relocations that apply to one section sorted by r_offset, along with
+  // the symbol table they reference through the relocation section's sh_link.
+  struct RelocIndex {
+    const Sym *symtab = nullptr;
+    size_t numSyms = 0;
+    std::vector<Reloc> relocs;
+  };
+
+  const Shdr *shdrs = nullptr;
+  size_t numShdrs = 0;
+  std::unordered_map<std::string_view, const Shdr *> sectionIndex;
+  // Keyed by the index of the section the relocations apply to.
+  std::unordered_map<size_t, RelocIndex> relocIndex;
+  // .zdebug_* sections are also indexed under their .debug_* name, which is
+  // stored here.
+  std::deque<std::string> uncompressedNames;
+
+  struct DecompressedSection {
+    std::unique_ptr<uint8_t[]> data;
+    size_t size = 0;
+  };
+  // Compressed sections are decompressed the first time they're looked up.
+  // Lookups can come from more than one thread.
+  mutable std::mutex decompressedMutex;
+  mutable std::unordered_map<const Shdr *, DecompressedSection> decompressed;
 
   template <typename RelType>
   std::pair<uint64_t, uint64_t> getRelocTypeAndSym(const RelType &rel) const {
@@ -96,76 +133,238 @@ class ELFReaderImpl final : public Reader {
     return {ELF64_R_TYPE(rel.r_info), ELF64_R_SYM(rel.r_info)};
   }
 
-  ErrorOr<uint64_t> getSymValue(const Sym &sym) const {
-    auto shdrTabOrErr = getShdrTable();
-    if (!shdrTabOrErr)
-      return shdrTabOrErr.getError();
-
-    auto [table, size] = *shdrTabOrErr;
-    if (sym.st_shndx >= size)
-      return "sym.st_shndx is larger than section header size"s;
+  ErrorOr<const uint8_t *> getSymValue(const Sym &sym) const {
+    if (sym.st_shndx >= numShdrs)
+      return Error::malformed(
+          "sym.st_shndx is larger than section header size");
 
-    return table[sym.st_shndx].sh_offset + sym.st_value;
+    Section section = getSectionData(shdrs[sym.st_shndx]);
+    if (!section)
+      return Error::malformed("Couldn't read section of relocation symbol");
+    return section.data + sym.st_value;
   }
 
-  template <typename RelType>
-  ErrorOr<uint64_t> resolveLocalDefinedReloc(const RelType &rel) const {
-    ErrorOr<const Shdr &> symtabShdrOrErr = getSectionHeader(".symtab");
-    if (!symtabShdrOrErr)
-      return symtabShdrOrErr.getError();
+  ErrorOr<const uint8_t *> resolveLocalDefinedReloc(const RelocIndex &index,
+                                                    const Reloc &rel) const {
+    assert((rel.type == R_X86_64_32 || rel.type == R_X86_64_64) &&
+           "Can only handle these basic relocs for now");
+
+    if (rel.sym >= index.numSyms)
+      return Error::malformed(
+          "Relocation symbol '{}' is too large for symtab of size '{}'",
+          rel.sym, index.numSyms);
 
-    const Sym *symtab =
-        reinterpret_cast<const Sym *>(getSectionAddr(*symtabShdrOrErr));
-    size_t numSyms = symtabShdrOrErr->sh_size / sizeof(Sym);
-    auto [type, sym] = getRelocTypeAndSym(rel);
+    return getSymValue(index.symtab[rel.sym]);
+  }
 
-    assert(type == R_X86_64_32 ||
-           type == R_X86_64_64 && "Can only handle these basic relocs for now");
+  ErrorOr<const uint8_t *> resolveLocalReloc(size_t sectionIndex,
+                                             uint64_t offset) const {
+    auto indexIt = relocIndex.find(sectionIndex);
+    if (indexIt == relocIndex.end())
+      return Error::notFound("Couldn't find relocations for section");
+    const RelocIndex &index = indexIt->second;
 
-    if (sym >= numSyms)
-      return "Relocation symbol '"s + std::to_string(sym) +
-             "' is too large for symtab of size '" + std::to_string(numSyms) +
-             '\'';
+    auto it = std::lower_bound(
+        index.relocs.begin(), index.relocs.end(), offset,
+        [](const Reloc &rel, uint64_t offset) { return rel.offset < offset; });
+    if (it == index.relocs.end() || it->offset != offset)
+      return Error::notFound("Couldn't find relocation at offset");
 
-    ErrorOr<uint64_t> symValOrErr = getSymValue(symtab[sym]);
-    if (!symValOrErr)
-      return symValOrErr.getError();
+    ErrorOr<const uint8_t *> symOrErr = resolveLocalDefinedReloc(index, *it);
+    if (!symOrErr)
+      return symOrErr.takeError();
 
-    return *symValOrErr;
+    return *symOrErr + it->addend;
   }
 
   ErrorOr<std::pair<const Shdr *, size_t>> getShdrTable() const {
     const Ehdr &ehdr =
         *reinterpret_cast<const Ehdr *>(getFileReader().getFileBuffer());
     if (!ehdr.e_shoff)
-      return "No section headers in binary"s;
+      return Error::notFound("No section headers in binary");
 
     const Shdr *shdr = reinterpret_cast<const Shdr *>(
         getFileReader().getFileBuffer() + ehdr.e_shoff);
     if (ehdr.e_shstrndx >= ehdr.e_shnum)
-      return "String table section larger than known sections"s;
+      return Error::malformed(
+          "String table section larger than known sections");
 
     return std::pair<const Shdr *, size_t>{shdr, ehdr.e_shnum};
   }
 
-  ErrorOr<const Shdr &> getSectionHeader(std::string_view name) const {
-    const Ehdr &ehdr =
-        *reinterpret_cast<const Ehdr *>(getFileReader().getFileBuffer());
+  // Build the name -> section header index once so that getSection and
+  // getSectionHeader don't need to walk the section header table and strcmp
+  // against .shstrtab on every call.
+  void buildSectionIndex() {
     auto shdrOrErr = getShdrTable();
     if (!shdrOrErr)
-      return shdrOrErr.getError();
-    const Shdr *shdr = shdrOrErr->first;
+      return;
+    std::tie(shdrs, numShdrs) = *shdrOrErr;
+
+    sectionIndex.reserve(numShdrs);
+    for (const Shdr *currentSection = shdrs, *end = shdrs + numShdrs;
+         currentSection != end; currentSection++) {
+      std::string_view name = getSectionName(*currentSection);
+      if (!name.data())
+        continue;
+      // Keep the first section of a given name, which is what the linear scan
+      // used to find, unless it's in a group and a later one isn't.
+      auto [it, inserted] =
+          sectionIndex.emplace(getUncompressedName(name), currentSection);
+      if (!inserted && (it->second->sh_flags & SHF_GROUP) &&
+          !(currentSection->sh_flags & SHF_GROUP))
+        it->second = currentSection;
+    }
+  }
+
+  static bool isGNUCompressed(std::string_view name) {
+    return name.substr(0, 8) == ".zdebug_";
+  }
 
-    const Shdr &shstr = shdr[ehdr.e_shstrndx];
-    const char *const strtab =
-        getFileReader().getFileBuffer() + shstr.sh_offset;
+  // The name a section is indexed under, which drops the z from .zdebug_*.
+  std::string_view getUncompressedName(std::string_view name) {
+    if (!isGNUCompressed(name))
+      return name;
+    return uncompressedNames.emplace_back(".debug_"s +
+                                          std::string{name.substr(8)});
+  }
 
-    for (const Shdr *currentSection = shdr, *end = shdr + ehdr.e_shnum;
-         currentSection != end; currentSection++)
-      if (name == std::string_view{strtab + currentSection->sh_name})
-        return *currentSection;
+  ErrorOr<DecompressedSection> decompressSection(const Shdr &shdr,
+                                                 bool isGNU) const {
+    const uint8_t *data = getSectionAddr(shdr);
+    size_t size = shdr.sh_size;
+    Decompress::Format format = Decompress::Format::Zlib;
+    uint64_t uncompressedSize = 0;
+    if (isGNU) {
+      // "ZLIB" followed by the uncompressed size as a big endian 64 bit
+      // integer.
+      if (size < 12 || std::memcmp(data, "ZLIB", 4))
+        return Error::malformed("Malformed compressed section header");
+      for (int i = 4; i < 12; i++)
+        uncompressedSize = uncompressedSize << 8 | data[i];
+      data += 12;
+      size -= 12;
+    } else {
+      if (size < sizeof(Chdr))
+        return Error::malformed("Malformed compressed section header");
+      const Chdr &chdr = *reinterpret_cast<const Chdr *>(data);
+      if (chdr.ch_type == ELFCOMPRESS_ZSTD)
+        format = Decompress::Format::Zstd;
+      else if (chdr.ch_type != ELFCOMPRESS_ZLIB)
+        return Error::unsupported("Unknown compression type '{}'",
+                                  uint64_t{chdr.ch_type});
+      uncompressedSize = chdr.ch_size;
+      data += sizeof(Chdr);
+      size -= sizeof(Chdr);
+    }
+
+    // The size comes from the file, so it's checked before it's allocated.
+    if (uncompressedSize > Decompress::getMaxUncompressedSize(format, size) ||
+        uncompressedSize > SIZE_MAX)
+      return Error::malformed("Compressed section has uncompressed size '{}'",
+                              uncompressedSize);
+    DecompressedSection section{
+        std::unique_ptr<uint8_t[]>(new (std::nothrow)
+                                       uint8_t[uncompressedSize]),
+        static_cast<size_t>(uncompressedSize)};
+    if (!section.data)
+      return Error("Couldn't allocate decompressed section");
+    if (Error err = Decompress::decompress(format, data, size,
+                                           section.data.get(), section.size))
+      return err;
+    return std::move(section);
+  }
 
-    return "Couldn't find section '"s + name.data() + '\'';
+  Section getSectionData(const Shdr &shdr) const {
+    bool isGNU = isGNUCompressed(getSectionName(shdr));
+    size_t index = &shdr - shdrs;
+    if (!(shdr.sh_flags & SHF_COMPRESSED) && !isGNU)
+      return {getSectionAddr(shdr), static_cast<size_t>(shdr.sh_size), index};
+
+    std::lock_guard<std::mutex> lock(decompressedMutex);
+    auto [it, inserted] = decompressed.try_emplace(&shdr);
+    if (inserted) {
+      // Sections that can't be decompressed are left empty.
+      if (ErrorOr<DecompressedSection> sectionOrErr =
+              decompressSection(shdr, isGNU))
+        it->second = std::move(*sectionOrErr);
+    }
+    return {it->second.data.get(), it->second.size, index};
+  }
+
+  std::string_view getSectionName(const Shdr &shdr) const {
+    const Ehdr &ehdr =
+        *reinterpret_cast<const Ehdr *>(getFileReader().getFileBuffer());
+    const Shdr &shstr = shdrs[ehdr.e_shstrndx];
+    if (shdr.sh_name >= shstr.sh_size)
+      return {};
+    return getFileReader().getFileBuffer() + shstr.sh_offset + shdr.sh_name;
+  }
+
+  template <typename RelType>
+  static int64_t getAddend(const RelType &rel, uint32_t type,
+                           const uint8_t *target) {
+    if constexpr (std::is_same_v<RelType, Rela>) {
+      return rel.r_addend;
+    } else {
+      if (addrSize == AddressSize::Eight && type == R_X86_64_64)
+        return *reinterpret_cast<const int64_t *>(target + rel.r_offset);
+      return *reinterpret_cast<const int32_t *>(target + rel.r_offset);
+    }
+  }
+
+  template <typename RelType> void addRelocSection(const Shdr &relShdr) {
+    if (relShdr.sh_info >= numShdrs || relShdr.sh_link >= numShdrs)
+      return;
+    const Shdr &target = shdrs[relShdr.sh_info];
+    const Shdr &symtab = shdrs[relShdr.sh_link];
+
+    RelocIndex &index = relocIndex[relShdr.sh_info];
+    index.symtab = reinterpret_cast<const Sym *>(getSectionAddr(symtab));
+    index.numSyms = symtab.sh_size / sizeof(Sym);
+
+    const RelType *rels =
+        reinterpret_cast<const RelType *>(getSectionAddr(relShdr));
+    size_t numRels = relShdr.sh_size / sizeof(RelType);
+    // Only Rel needs to read the section being relocated.
+    const uint8_t *targetData = nullptr;
+    if constexpr (std::is_same_v<RelType, Rel>)
+      targetData = getSectionData(target).data;
+    index.relocs.reserve(index.relocs.size() + numRels);
+    for (const RelType *rel = rels, *end = rels + numRels; rel != end; rel++) {
+      auto [type, sym] = getRelocTypeAndSym(*rel);
+      index.relocs.push_back({static_cast<uint64_t>(rel->r_offset),
+                              static_cast<uint32_t>(type),
+                              static_cast<uint32_t>(sym),
+                              getAddend(*rel, type, targetData)});
+    }
+  }
+
+  // Relocations are only ever looked up by the offset they apply to, so sort
+  // them once here and binary search them later instead of scanning the whole
+  // relocation section for every lookup.
+  void buildRelocIndex() {
+    for (const Shdr *currentSection = shdrs, *end = shdrs + numShdrs;
+         currentSection != end; currentSection++) {
+      if (currentSection->sh_type == SHT_RELA)
+        addRelocSection<Rela>(*currentSection);
+      else if (currentSection->sh_type == SHT_REL)
+        addRelocSection<Rel>(*currentSection);
+    }
+
+    for (auto &[_, index] : relocIndex)
+      std::stable_sort(index.relocs.begin(), index.relocs.end(),
+                       [](const Reloc &a, const Reloc &b) {
+                         return a.offset < b.offset;
+                       });
+  }
+
+  ErrorOr<const Shdr &> getSectionHeader(std::string_view name) const {
+    numSectionLookups++;
+    auto it = sectionIndex.find(name);
+    if (it == sectionIndex.end())
+      return Error::notFound("Couldn't find section '{}'", name);
+    return *it->second;
   }
 
   // TODO maybe error check...
@@ -175,36 +374,49 @@ class ELFReaderImpl final : public Reader {
   }
 
 public:
-  ELFReaderImpl(FileReader &&file) : Reader(std::move(file)) {}
+  ELFReaderImpl(FileReader &&file) : Reader(std::move(file)) {
+    buildSectionIndex();
+    buildRelocIndex();
+  }
 
   // TODO: don't assume same endianness as currently running on.
-  const uint8_t *getSection(std::string_view name) const override {
+  Section getSection(std::string_view name) const override {
     ErrorOr<const Shdr &> shdrOrErr = getSectionHeader(name);
     if (!shdrOrErr)
-      return nullptr;
-    return getSectionAddr(*shdrOrErr);
+      return {};
+    return getSectionData(*shdrOrErr);
+  }
+
+  std::vector<Section> getSections(std::string_view name) const override {
+    numSectionLookups++;
+    std::vector<Section> sections;
+    for (const Shdr *currentSection = shdrs, *end = shdrs + numShdrs;
+         currentSection != end; currentSection++) {
+      std::string_view sectionName = getSectionName(*currentSection);
+      // .zdebug_* matches the .debug_* name it decompresses to.
+      if (sectionName.data() &&
+          (sectionName == name ||
+           (isGNUCompressed(sectionName) && !name.compare(0, 7, ".debug_") &&
+            sectionName.substr(8) == name.substr(7))))
+        sections.push_back(getSectionData(*currentSection));
+    }
+    return sections;
   }
 
-  // TODO right now only Rela is being handled because it's all that's needed
-  // but eventually handle just Rel's too.
   ErrorOr<const uint8_t *>
   attemptResolveLocalReloc(std::string_view section_name,
                            uint64_t offset) const override {
-    std::string relaSection = ".rela"s + section_name.data();
-    ErrorOr<const Shdr &> relShdrOrErr = getSectionHeader(relaSection);
-    if (!relShdrOrErr)
-      return relShdrOrErr.getError();
-
-    const Rela *rela = getRelocForOffset<Rela>(*relShdrOrErr, offset);
-    if (!rela)
-      return "Couldn't find relocation at offset"s;
-
-    ErrorOr<uint64_t> offsetOrErr = resolveLocalDefinedReloc(*rela);
-    if (!offsetOrErr)
-      return offsetOrErr.getError();
+    auto it = sectionIndex.find(section_name);
+    if (it == sectionIndex.end())
+      return Error::notFound("Couldn't find relocations for section '{}'",
+                             section_name);
+    return resolveLocalReloc(it->second - shdrs, offset);
+  }
 
-    return reinterpret_cast<const uint8_t *>(getFileReader().getFileBuffer()) +
-           *offsetOrErr + rela->r_addend;
+  ErrorOr<const uint8_t *>
+  attemptResolveLocalReloc(const Section &section,
+                           uint64_t offset) const override {
+    return resolveLocalReloc(section.index, offset);
   }
 
   Triple getTriple() const override {
@@ -230,6 +442,22 @@ std::unique_ptr<Reader> Reader::create(FileReader &&file, Triple t) {
   return nullptr;
 }
 
+std::string_view Reader::getBuildID() const {
+  // The note is an Elf_Nhdr, which is the same for both classes, then the
+  // name "GNU" padded to 4 bytes and then the ID.
+  Section note = getSection(".note.gnu.build-id");
+  if (note.size < sizeof(Elf64_Nhdr) + 4)
+    return {};
+  const auto *nhdr = reinterpret_cast<const Elf64_Nhdr *>(note.data);
+  const uint8_t *name = note.data + sizeof(Elf64_Nhdr);
+  if (nhdr->n_type != NT_GNU_BUILD_ID || nhdr->n_namesz != 4 ||
+      std::memcmp(name, "GNU", 4))
+    return {};
+  if (nhdr->n_descsz > note.size - sizeof(Elf64_Nhdr) - 4)
+    return {};
+  return {reinterpret_cast<const char *>(name + 4), nhdr->n_descsz};
+}
+
 std::unique_ptr<Reader> Reader::create(FileReader &&file) {
   std::optional<Triple> triple = ELF::acceptor(file);
   return triple ? create(std::move(file), *triple) : nullptr;
@@ -12,17 +12,32 @@
 #ifndef CEDO_LIB_BINFMT_ELF_H
 #define CEDO_LIB_BINFMT_ELF_H
 
+#include <atomic>
+#include <cstdint>
 #include <memory>
 #include <optional>
 #include <string_view>
+#include <vector>
 
 #include "cedo/Binfmt/Binfmt.h"
 #include "cedo/Core/FileReader.h"
 
 namespace ELF {
 
+struct Section {
+  const uint8_t *data = nullptr;
+  size_t size = 0;
+  // Index of the section header, which tells apart sections with the same
+  // name. 0 for sections that don't come from a section header.
+  size_t index = 0;
+
+  explicit operator bool() const { return data; }
+};
+
 class Reader : public ObjectFileReader {
 protected:
+  mutable std::atomic<size_t> numSectionLookups = 0;
+
   Reader(FileReader &&file) : ObjectFileReader(std::move(file)) {}
 
 public:
@@ -30,12 +45,32 @@ public:
   static std::unique_ptr<Reader> create(FileReader &&file, Triple t);
 
   // This does not change the underlying file or it's buffer, just returns the
-  // value.
+  // value. Errors refer to section_name, so it has to outlive them.
   virtual ErrorOr<const uint8_t *>
   attemptResolveLocalReloc(std::string_view section_name,
                            uint64_t offset) const = 0;
+  // Same as above for a section returned by getSection or getSections.
+  virtual ErrorOr<const uint8_t *>
+  attemptResolveLocalReloc(const Section &section, uint64_t offset) const = 0;
+
+  // Section lookups are backed by a name index built when the reader is
+  // created, so they are cheap enough to call on hot paths. Compressed
+  // sections, SHF_COMPRESSED or .zdebug_*, are decompressed on their first
+  // lookup and found by their uncompressed name. A section that can't be
+  // decompressed is empty.
+  // When more than one section has the name, like the .debug_info sections
+  // of type units in COMDAT groups, the first one outside of a group is found.
+  virtual Section getSection(std::string_view name) const = 0;
+  // Every section with the name, in section header order. This walks the
+  // section headers.
+  virtual std::vector<Section> getSections(std::string_view name) const = 0;
+
+  std::string_view getBuildID() const override;
 
-  virtual const uint8_t *getSection(std::string_view name) const = 0;
+  // Number of section lookups made so far, used to keep track of how many
+  // lookups parsing an object takes. Units are parsed on multiple threads so
+  // this is atomic.
+  size_t getNumSectionLookups() const { return numSectionLookups; }
 };
 
 constexpr std::string_view magic = "\x7f"
@@ -0,0 +1,323 @@
+// Copyright 2021 Alex Brachet (alex@brachet.dev)
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <unordered_map>
+
+#include "cedo/Binfmt/TypeCache.h"
+
+using namespace std::string_literals;
+
+static constexpr char magic[8] = "CEDOTC2";
+static constexpr uint32_t noType = UINT32_MAX;
+// Marks a type that is being created, to catch arrays containing themselves
+// in a corrupt file.
+static const Type *const creating = reinterpret_cast<const Type *>(1);
+
+struct TypeCache::Header {
+  char magic[8];
+  uint32_t numVariables;
+  uint32_t numTypes;
+  uint32_t numMembers;
+  uint32_t stringsSize;
+};
+
+// Sorted by name.
+struct TypeCache::VariableRecord {
+  uint32_t nameOffset;
+  uint32_t nameSize;
+  uint32_t linkageNameOffset;
+  uint32_t linkageNameSize;
+  uint32_t type;
+  uint32_t padding;
+};
+
+struct TypeCache::TypeRecord {
+  enum Kind : uint32_t { Base, Array, Struct, Pointer };
+
+  Kind kind;
+  // The element type for arrays, the pointing type for pointers and the first
+  // member for structs.
+  uint32_t ref;
+  // Number of elements for arrays and members for structs.
+  uint64_t count;
+  uint64_t byteSize;
+};
+
+struct TypeCache::MemberRecord {
+  uint32_t type;
+  uint32_t padding;
+  int64_t offset;
+};
+
+std::string TypeCache::getFileName(const ObjectFileReader &objectFileReader) {
+  static constexpr char hexDigits[] = "0123456789abcdef";
+  std::string name;
+  std::string_view buildID = objectFileReader.getBuildID();
+  if (buildID.empty()) {
+    // FNV-1a
+    const FileReader &file = objectFileReader.getFileReader();
+    uint64_t hash = 0xcbf29ce484222325;
+    for (size_t i = 0; i < file.getFileSize(); i++)
+      hash = (hash ^ static_cast<uint8_t>(file.getFileBuffer()[i])) *
+             0x100000001b3;
+    name = "hash-";
+    for (int shift = 60; shift >= 0; shift -= 4)
+      name += hexDigits[(hash >> shift) & 0xf];
+  } else {
+    for (unsigned char c : buildID) {
+      name += hexDigits[c >> 4];
+      name += hexDigits[c & 0xf];
+    }
+  }
+  return name + ".cedo-cache";
+}
+
+ErrorOr<TypeCache> TypeCache::open(std::string_view path) {
+  // Records are used in place from the mapping, so every array has to start
+  // at an 8-byte boundary.
+  static_assert(sizeof(Header) % alignof(TypeRecord) == 0);
+  static_assert(sizeof(VariableRecord) == 24);
+  static_assert(sizeof(TypeRecord) == 24 && alignof(TypeRecord) == 8);
+  static_assert(sizeof(MemberRecord) == 16 && alignof(MemberRecord) == 8);
+
+  ErrorOr<FileReader> fileOrErr = FileReader::open(path);
+  if (!fileOrErr)
+    return fileOrErr.getError();
+  TypeCache cache{std::move(*fileOrErr)};
+
+  const char *data = cache.file.getFileBuffer();
+  size_t size = cache.file.getFileSize();
+  const std::string invalid = "Invalid cache file \""s + path.data() + '"';
+  if (size < sizeof(Header) ||
+      reinterpret_cast<uintptr_t>(data) % alignof(TypeRecord))
+    return invalid;
+  cache.header = reinterpret_cast<const Header *>(data);
+  if (std::memcmp(cache.header->magic, magic, sizeof(magic)))
+    return invalid;
+
+  uint64_t expectedSize =
+      sizeof(Header) +
+      uint64_t{cache.header->numVariables} * sizeof(VariableRecord) +
+      uint64_t{cache.header->numTypes} * sizeof(TypeRecord) +
+      uint64_t{cache.header->numMembers} * sizeof(MemberRecord) +
+      cache.header->stringsSize;
+  if (expectedSize != size)
+    return invalid;
+
+  data += sizeof(Header);
+  cache.variables = reinterpret_cast<const VariableRecord *>(data);
+  data += cache.header->numVariables * sizeof(VariableRecord);
+  cache.types = reinterpret_cast<const TypeRecord *>(data);
+  data += cache.header->numTypes * sizeof(TypeRecord);
+  cache.members = reinterpret_cast<const MemberRecord *>(data);
+  data += cache.header->numMembers * sizeof(MemberRecord);
+  cache.strings = data;
+  return cache;
+}
+
+std::string_view TypeCache::getString(uint32_t offset, uint32_t size) const {
+  if (offset > header->stringsSize || size > header->stringsSize - offset)
+    return {};
+  return {strings + offset, size};
+}
+
+const Type *TypeCache::createType(uint32_t index) {
+  if (index >= header->numTypes)
+    return nullptr;
+  if (createdTypes.empty())
+    createdTypes.resize(header->numTypes);
+  if (const Type *type = createdTypes[index])
+    return type == creating ? nullptr : type;
+
+  const TypeRecord &record = types[index];
+  switch (record.kind) {
+  case TypeRecord::Base:
+    return createdTypes[index] =
+               typeGraph->create<BaseType>(0, record.byteSize);
+  case TypeRecord::Array: {
+    createdTypes[index] = creating;
+    const Type *elementType = createType(record.ref);
+    createdTypes[index] = nullptr;
+    if (!elementType)
+      return nullptr;
+    return createdTypes[index] =
+               typeGraph->create<ArrayType>(0, elementType, record.count);
+  }
+  case TypeRecord::Struct: {
+    if (record.ref > header->numMembers ||
+        record.count > header->numMembers - record.ref)
+      return nullptr;
+    // Created before its members, like in DWARF, so pointers back to it work.
+    StructType *structType = typeGraph->create<StructType>(0, record.byteSize);
+    createdTypes[index] = structType;
+    for (uint64_t i = 0; i < record.count; i++) {
+      const MemberRecord &member = members[record.ref + i];
+      const Type *memberType = createType(member.type);
+      if (!memberType) {
+        createdTypes[index] = nullptr;
+        return nullptr;
+      }
+      structType->members.emplace_back(memberType, member.offset);
+    }
+    return structType;
+  }
+  case TypeRecord::Pointer: {
+    PointerType *pointerType =
+        typeGraph->create<PointerType>(Type::Qualifier::Pointer, nullptr);
+    createdTypes[index] = pointerType;
+    if (record.ref != noType)
+      pointerType->pointingType = createType(record.ref);
+    return pointerType;
+  }
+  }
+  return nullptr;
+}
+
+std::optional<TypeCache::Variable> TypeCache::find(std::string_view name) {
+  const VariableRecord *end = variables + header->numVariables;
+  const VariableRecord *it =
+      std::lower_bound(variables, end, name,
+                       [this](const VariableRecord &v, std::string_view name) {
+                         return getString(v.nameOffset, v.nameSize) < name;
+                       });
+  if (it == end || getString(it->nameOffset, it->nameSize) != name)
+    return {};
+  const Type *type = createType(it->type);
+  if (!type)
+    return {};
+  return Variable{std::string{name},
+                  std::string{getString(it->linkageNameOffset,
+                                        it->linkageNameSize)},
+                  type};
+}
+
+std::vector<TypeCache::Variable> TypeCache::getVariables() {
+  std::vector<Variable> result;
+  for (uint32_t i = 0; i < header->numVariables; i++) {
+    const VariableRecord &v = variables[i];
+    if (const Type *type = createType(v.type))
+      result.push_back({std::string{getString(v.nameOffset, v.nameSize)},
+                        std::string{getString(v.linkageNameOffset,
+                                              v.linkageNameSize)},
+                        type});
+  }
+  return result;
+}
+
+std::string TypeCache::write(std::string_view path,
+                             const std::vector<Variable> &variables) {
+  // Number every reachable type, each is only written once.
+  std::unordered_map<const Type *, uint32_t> typeIndices;
+  std::vector<const Type *> typeList;
+  auto addType = [&](const Type *type) {
+    if (type && typeIndices.emplace(type, typeList.size()).second)
+      typeList.push_back(type);
+  };
+  for (const Variable &variable : variables)
+    addType(variable.type);
+  for (size_t i = 0; i < typeList.size(); i++) {
+    if (const auto *array = dynamic_cast<const ArrayType *>(typeList[i]))
+      addType(array->elementType);
+    else if (const auto *s = dynamic_cast<const StructType *>(typeList[i]))
+      for (const auto &[memberType, _] : s->members)
+        addType(memberType);
+    else if (const auto *pointer =
+                 dynamic_cast<const PointerType *>(typeList[i]))
+      addType(pointer->pointingType);
+  }
+  auto indexOf = [&](const Type *type) {
+    return type ? typeIndices[type] : noType;
+  };
+
+  std::vector<TypeRecord> typeRecords;
+  std::vector<MemberRecord> memberRecords;
+  for (const Type *type : typeList) {
+    TypeRecord &record = typeRecords.emplace_back();
+    record = {TypeRecord::Base, noType, 0, type->getObjectSize()};
+    if (const auto *array = dynamic_cast<const ArrayType *>(type)) {
+      record.kind = TypeRecord::Array;
+      record.ref = indexOf(array->elementType);
+      record.count = array->numElements;
+    } else if (const auto *s = dynamic_cast<const StructType *>(type)) {
+      record.kind = TypeRecord::Struct;
+      record.ref = memberRecords.size();
+      record.count = s->members.size();
+      for (const auto &[memberType, offset] : s->members)
+        memberRecords.push_back({indexOf(memberType), 0, offset});
+    } else if (const auto *pointer = dynamic_cast<const PointerType *>(type)) {
+      record.kind = TypeRecord::Pointer;
+      record.ref = indexOf(pointer->pointingType);
+    }
+  }
+
+  std::vector<const Variable *> sorted;
+  for (const Variable &variable : variables)
+    if (variable.type)
+      sorted.push_back(&variable);
+  std::sort(sorted.begin(), sorted.end(),
+            [](const Variable *a, const Variable *b) {
+              return a->name < b->name;
+            });
+  sorted.erase(std::unique(sorted.begin(), sorted.end(),
+                           [](const Variable *a, const Variable *b) {
+                             return a->name == b->name;
+                           }),
+               sorted.end());
+
+  std::string strings;
+  std::vector<VariableRecord> variableRecords;
+  for (const Variable *variable : sorted) {
+    VariableRecord &record = variableRecords.emplace_back();
+    record.nameOffset = strings.size();
+    record.nameSize = variable->name.size();
+    strings += variable->name;
+    record.linkageNameOffset = strings.size();
+    record.linkageNameSize = variable->linkageName.size();
+    strings += variable->linkageName;
+    record.type = indexOf(variable->type);
+  }
+
+  Header header;
+  std::memcpy(header.magic, magic, sizeof(magic));
+  header.numVariables = variableRecords.size();
+  header.numTypes = typeRecords.size();
+  header.numMembers = memberRecords.size();
+  header.stringsSize = strings.size();
+
+  std::string tmpPath = std::string{path} + ".tmp" + std::to_string(::getpid());
+  {
+    std::ofstream out{tmpPath, std::ios::binary};
+    if (!out)
+      return "Couldn't open \""s + tmpPath + "\" for writing";
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char *>(variableRecords.data()),
+              variableRecords.size() * sizeof(VariableRecord));
+    out.write(reinterpret_cast<const char *>(typeRecords.data()),
+              typeRecords.size() * sizeof(TypeRecord));
+    out.write(reinterpret_cast<const char *>(memberRecords.data()),
+              memberRecords.size() * sizeof(MemberRecord));
+    out.write(strings.data(), strings.size());
+    if (!out)
+      return "Couldn't write \""s + tmpPath + '"';
+  }
+  if (std::rename(tmpPath.c_str(), std::string{path}.c_str())) {
+    std::remove(tmpPath.c_str());
+    return "Couldn't rename \""s + tmpPath + '"';
+  }
+  return {};
+}
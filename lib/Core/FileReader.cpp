@@ -21,7 +21,8 @@
 #include "cedo/Core/ErrorOr.h"
 #include "cedo/Core/FileReader.h"
 
-ErrorOr<FileReader> FileReader::open(std::string_view filename) {
+ErrorOr<FileReader> FileReader::open(std::string_view filename,
+                                     MapMode mode) {
   using namespace std::string_literals;
   int fd = ::open(filename.data(), O_RDONLY);
   if (fd == -1)
@@ -31,12 +32,37 @@ ErrorOr<FileReader> FileReader::open(std::string_view filename) {
   if (::fstat(fd, &s) == -1)
     return "Couldn't stat file \""s + filename.data() + "\"";
 
-  void *mapping =
-      ::mmap(nullptr, s.st_size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+  int flags = MAP_PRIVATE | (mode == MapMode::Populate ? MAP_POPULATE : 0);
+  void *mapping = ::mmap(nullptr, s.st_size, PROT_READ, flags, fd, 0);
   (void)::close(fd);
   if (mapping == MAP_FAILED)
     return "mmap failed"s;
-  return FileReader{mapping, static_cast<size_t>(s.st_size)};
+  if (mode == MapMode::Lazy)
+    (void)::madvise(mapping, s.st_size, MADV_RANDOM);
+  return FileReader{mapping, static_cast<size_t>(s.st_size), mode};
+}
+
+void FileReader::advise(const void *start, size_t length, int advice) const {
+  if (mode != MapMode::Lazy || !length)
+    return;
+  // Sections can be decompressed into memory outside of the mapping, which
+  // must not be touched.
+  uintptr_t begin = reinterpret_cast<uintptr_t>(start);
+  uintptr_t end = begin + length;
+  uintptr_t mappingBegin = reinterpret_cast<uintptr_t>(file_mapping);
+  if (begin < mappingBegin || end > mappingBegin + size)
+    return;
+  // madvise needs a page aligned start. Only the pages entirely inside the
+  // range are dropped, others may still have something else in use.
+  uintptr_t pageSize = ::sysconf(_SC_PAGESIZE);
+  if (advice == MADV_DONTNEED) {
+    begin = (begin + pageSize - 1) & ~(pageSize - 1);
+    end &= ~(pageSize - 1);
+  } else {
+    begin &= ~(pageSize - 1);
+  }
+  if (begin < end)
+    (void)::madvise(reinterpret_cast<void *>(begin), end - begin, advice);
 }
 
 FileReader::~FileReader() {
@@ -9,18 +9,24 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <fcntl.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
 #include <cstdio>
-#include <fstream>
+#include <cstdlib>
+#include <optional>
 #include <string>
 #include <string_view>
 #include <vector>
 
 #include "cedo/Backend/EmitAsm.h"
+#include "cedo/Backend/EmitObject.h"
 #include "cedo/Binfmt/Binfmt.h"
 #include "cedo/Binfmt/DWARF.h"
+#include "cedo/Binfmt/TypeCache.h"
 #include "cedo/Core/FileReader.h"
+#include "cedo/Core/PageFaults.h"
 #include "cedo/Runtime/Runtime.h"
 
 #include "version/Version.h"
@@ -29,8 +35,17 @@ struct Args {
   std::string_view inputFile;
   std::string outputFile;
   std::vector<std::string_view> outputSyms;
+  std::string_view cacheDir;
+  std::string_view debugFile;
+  // Pointer-free ranges this large or larger go to a .bin file next to the
+  // output, if it's set.
+  uint64_t incbinThreshold = 0;
   bool saveTemps = false;
+  // Write an object instead of assembly, -S takes precedence like with cc.
+  bool compileOnly = false;
   bool emitVersion = true;
+  bool cacheStats = false;
+  bool parseStats = false;
 };
 
 Args parseArgs(int argc, const char **argv) {
@@ -43,6 +58,10 @@ Args parseArgs(int argc, const char **argv) {
       args.saveTemps = 1;
       continue;
     }
+    if ("-c"s == *current) {
+      args.compileOnly = true;
+      continue;
+    }
     if ("-s"s == *current || "--sym"s == *current) {
       args.outputSyms.emplace_back(*++current);
       continue;
@@ -57,11 +76,45 @@ Args parseArgs(int argc, const char **argv) {
       continue;
     }
 
+    if ("--cache-dir"s == *current) {
+      args.cacheDir = *++current;
+      continue;
+    }
+
+    if ("--debug-file"s == *current) {
+      args.debugFile = *++current;
+      continue;
+    }
+
+    if ("--incbin-threshold"s == *current) {
+      args.incbinThreshold = std::strtoull(*++current, nullptr, 10);
+      if (!args.incbinThreshold) {
+        std::fputs("--incbin-threshold must be a positive size\n", stderr);
+        std::exit(1);
+      }
+      continue;
+    }
+
+    if ("--cache-stats"s == *current) {
+      args.cacheStats = true;
+      continue;
+    }
+
+    if ("--parse-stats"s == *current) {
+      args.parseStats = true;
+      continue;
+    }
+
     args.inputFile = *current;
   }
 
-  if (!args.saveTemps) {
-    std::fputs("-S must currently be specified\n", stderr);
+  if (!args.saveTemps && !args.compileOnly) {
+    std::fputs("-S or -c must currently be specified\n", stderr);
+    std::exit(1);
+  }
+
+  if (args.incbinThreshold && !args.saveTemps) {
+    std::fputs("--incbin-threshold can only be used with -S\n", stderr);
     std::exit(1);
   }
 
@@ -80,7 +133,7 @@ Args parseArgs(int argc, const char **argv) {
     auto it = out.rfind(".");
     if (it != out.npos)
       out.resize(it);
-    out += ".s";
+    out += args.saveTemps ? ".s" : ".o";
     args.outputFile = std::move(out);
   }
 
@@ -91,16 +144,105 @@ void warn(std::string_view warning) {
   std::fprintf(stderr, "Warning: %s\n", warning.data());
 }
 
-static ErrorOr<std::pair<std::vector<Sym>, Triple>>
+struct ResolvedSyms {
+  std::vector<Sym> syms;
+  Triple triple;
+  // Own the types in syms.
+  std::vector<std::shared_ptr<const TypeGraph>> types;
+};
+
+struct Stats {
+  size_t cacheHits = 0;
+  size_t cacheMisses = 0;
+  // Taken from opening the object until every variable was found.
+  PageFaults parseFaults;
+};
+
+// Finds each of outputSyms' linkage name and type, from the cache in cacheDir
+// if there is one and otherwise from DWARF. Variables read from DWARF are added
+// to the cache. Variables which can't be found are left empty.
+static ErrorOr<std::vector<std::optional<TypeCache::Variable>>>
+findVariables(const ObjectFileReader &objFileReader,
+              const std::vector<std::string_view> &outputSyms,
+              const DebugFileOptions &debugFileOptions,
+              std::string_view cacheDir, Stats &stats,
+              ResolvedSyms &resolvedSyms) {
+  using namespace std::string_literals;
+
+  std::vector<std::optional<TypeCache::Variable>> variables(outputSyms.size());
+  std::optional<TypeCache> cache;
+  std::string cachePath;
+  if (!cacheDir.empty()) {
+    ::mkdir(std::string{cacheDir}.c_str(), 0777);
+    cachePath = std::string{cacheDir} + '/' +
+                TypeCache::getFileName(objFileReader);
+    if (ErrorOr<TypeCache> cacheOrErr = TypeCache::open(cachePath))
+      cache.emplace(std::move(*cacheOrErr));
+  }
+
+  std::vector<std::string_view> missing;
+  for (size_t i = 0; i < outputSyms.size(); i++) {
+    if (cache)
+      variables[i] = cache->find(outputSyms[i]);
+    if (variables[i]) {
+      stats.cacheHits++;
+      continue;
+    }
+    missing.push_back(outputSyms[i]);
+    if (!cacheDir.empty())
+      stats.cacheMisses++;
+  }
+  if (cache)
+    resolvedSyms.types.push_back(cache->getTypeGraph());
+  if (missing.empty())
+    return variables;
+
+  ErrorOr<DWARF> debugSymbols =
+      DWARF::readFromObject(objFileReader, missing,
+                            DWARF::ParseMode::VariablesAndTypes,
+                            debugFileOptions);
+  if (!debugSymbols)
+    return debugSymbols.getError();
+  resolvedSyms.types.push_back(debugSymbols->getTypeGraph());
+
+  std::vector<TypeCache::Variable> toCache;
+  if (cache)
+    toCache = cache->getVariables();
+  for (size_t i = 0; i < outputSyms.size(); i++) {
+    if (variables[i])
+      continue;
+    const Type *type = debugSymbols->getVariableType(outputSyms[i]);
+    if (!type)
+      continue;
+    // Qualified C++ names like ns::table need to be looked up and emitted
+    // by their mangled name.
+    variables[i] = {
+        std::string{outputSyms[i]},
+        std::string{debugSymbols->getVariableLinkageName(outputSyms[i])},
+        type};
+    toCache.push_back(*variables[i]);
+  }
+
+  if (!cacheDir.empty())
+    if (std::string err = TypeCache::write(cachePath, toCache); !err.empty())
+      warn(err);
+  return variables;
+}
+
+static ErrorOr<ResolvedSyms>
 runUserCodeAndGetSyms(std::string_view userFilename,
-                      std::vector<std::string_view> outputSyms) {
+                      std::vector<std::string_view> outputSyms,
+                      std::string_view debugFile, std::string_view cacheDir,
+                      Stats &stats) {
   using namespace std::string_literals;
 
-  std::vector<Sym> resolvedSyms;
-  Triple triple;
+  ResolvedSyms resolvedSyms;
 
   auto concurrent = [&](const Runtime &runtime) -> std::string {
-    ErrorOr<FileReader> fileOrErr = FileReader::open(userFilename);
+    PageFaults faultsBefore = PageFaults::get();
+    // Only a few sections are read, so don't read in the whole file.
+    ErrorOr<FileReader> fileOrErr =
+        FileReader::open(userFilename, FileReader::MapMode::Lazy);
     if (!fileOrErr)
       return fileOrErr.getError();
 
@@ -109,27 +251,37 @@ runUserCodeAndGetSyms(std::string_view userFilename,
     if (!objFileReader)
       return "Couldn't read object file"s;
 
-    triple = objFileReader->getTriple();
-
-    ErrorOr<DWARF> debugSymbols = DWARF::readFromObject(*objFileReader);
-    if (!debugSymbols)
-      return debugSymbols.getError();
-
-    for (std::string_view symName : outputSyms) {
-      std::unique_ptr<Type> type = debugSymbols->getVariableType(symName);
-      if (!type) {
+    resolvedSyms.triple = objFileReader->getTriple();
+
+    // The debug info can be in a separate file, so what gets loaded and run
+    // can be stripped.
+    DebugFileOptions debugFileOptions;
+    debugFileOptions.debugFile = debugFile;
+    debugFileOptions.objectPath = userFilename;
+    auto variablesOrErr = findVariables(*objFileReader, outputSyms,
+                                        debugFileOptions, cacheDir, stats,
+                                        resolvedSyms);
+    if (!variablesOrErr)
+      return variablesOrErr.getError();
+    stats.parseFaults = PageFaults::get() - faultsBefore;
+
+    for (size_t i = 0; i < outputSyms.size(); i++) {
+      std::string_view symName = outputSyms[i];
+      std::optional<TypeCache::Variable> &variable = (*variablesOrErr)[i];
+      if (!variable) {
         warn("Couldn't find debug info for '"s + symName.data() + '\'');
         continue;
       }
 
-      void *symLocation = runtime.findSymbol(symName);
+      void *symLocation = runtime.findSymbol(variable->linkageName);
       if (!symLocation) {
         warn("Symbol '"s + symName.data() +
              "' is in debug info but was not found in shared object");
         continue;
       }
 
-      resolvedSyms.emplace_back(symName, std::move(type), symLocation);
+      resolvedSyms.syms.emplace_back(std::move(variable->linkageName),
+                                     variable->type, symLocation);
     }
 
     return {};
@@ -146,24 +298,77 @@ runUserCodeAndGetSyms(std::string_view userFilename,
   if (*exitCodeOrErr)
     return "Exit code: '"s + std::to_string(*exitCodeOrErr) + '\'';
 
-  return std::pair<std::vector<Sym>, Triple>{std::move(resolvedSyms), triple};
+  return std::move(resolvedSyms);
 }
 
 int main(int argc, const char **argv) {
   Args args = parseArgs(argc, argv);
 
-  ErrorOr<std::pair<std::vector<Sym>, Triple>> symsOrErr =
-      runUserCodeAndGetSyms(args.inputFile, args.outputSyms);
+  Stats stats;
+  ErrorOr<ResolvedSyms> symsOrErr = runUserCodeAndGetSyms(
+      args.inputFile, args.outputSyms, args.debugFile, args.cacheDir, stats);
   if (!symsOrErr) {
     std::fputs(symsOrErr.getError().c_str(), stderr);
     return 1;
   }
 
-  std::pair<std::vector<Sym>, Triple> &p = *symsOrErr;
+  if (args.cacheStats)
+    std::fprintf(stderr, "Cache: %zu hits, %zu misses\n", stats.cacheHits,
+                 stats.cacheMisses);
+  if (args.parseStats)
+    std::fprintf(stderr, "Parse: %zu minor, %zu major page faults\n",
+                 stats.parseFaults.minor, stats.parseFaults.major);
 
-  std::ofstream stream{args.outputFile};
-  AsmEmitter asmEmitter{p.second, stream};
-  asmEmitter.emitAsm(p.first, args.emitVersion ? createVersionString() : "");
+  ResolvedSyms &resolvedSyms = *symsOrErr;
+
+  int fd = ::open(args.outputFile.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+  if (fd < 0) {
+    std::fprintf(stderr, "Couldn't open '%s' for writing\n",
+                 args.outputFile.c_str());
+    return 1;
+  }
+
+  if (!args.saveTemps) {
+    ObjectEmitter objectEmitter{resolvedSyms.triple, fd};
+    if (Error err = objectEmitter.emitObjectFile(
+            resolvedSyms.syms, args.emitVersion ? createVersionString() : "")) {
+      std::fprintf(stderr, "%s\n", err.getMessage().c_str());
+      ::close(fd);
+      return 1;
+    }
+    if (objectEmitter.hasFailed() || ::close(fd)) {
+      std::fprintf(stderr, "Couldn't write '%s'\n", args.outputFile.c_str());
+      return 1;
+    }
+    return 0;
+  }
+
+  AsmEmitter asmEmitter{resolvedSyms.triple, fd};
+
+  int incbinFd = -1;
+  std::string incbinFile;
+  if (args.incbinThreshold) {
+    incbinFile = args.outputFile;
+    if (auto it = incbinFile.rfind('.');
+        it != incbinFile.npos && incbinFile.find('/', it) == incbinFile.npos)
+      incbinFile.resize(it);
+    incbinFile += ".bin";
+    incbinFd = ::open(incbinFile.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (incbinFd < 0) {
+      std::fprintf(stderr, "Couldn't open '%s' for writing\n",
+                   incbinFile.c_str());
+      return 1;
+    }
+    asmEmitter.setIncbinFile(incbinFd, incbinFile, args.incbinThreshold);
+  }
+
+  asmEmitter.emitAsm(resolvedSyms.syms,
+                     args.emitVersion ? createVersionString() : "");
+  if (asmEmitter.hasFailed() || ::close(fd) ||
+      (incbinFd >= 0 && ::close(incbinFd))) {
+    std::fprintf(stderr, "Couldn't write '%s'\n", args.outputFile.c_str());
+    return 1;
+  }
 
   return 0;
 }
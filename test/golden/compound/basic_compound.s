@@ -4,9 +4,6 @@
     .global a
     .align 1
 a:
-    .long 1
-    .long 2
-    .long 3
-    .long 4
+    .long 1, 2, 3, 4
 
     .ident "cedo"
@@ -0,0 +1,5 @@
+namespace ns {
+int a = 1234;
+}
+
+int main() {}
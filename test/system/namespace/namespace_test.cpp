@@ -0,0 +1,9 @@
+#include <assert.h>
+
+namespace ns {
+extern int a;
+}
+
+int main() {
+  assert(ns::a == 1234);
+}
@@ -0,0 +1,5 @@
+struct node {
+  struct node *self;
+  long a;
+  long b;
+};
@@ -0,0 +1,10 @@
+#include <assert.h>
+#include "object.h"
+
+extern struct node a;
+
+int main() {
+  assert(a.self == &a);
+  assert(a.a == 1);
+  assert(a.b == 2);
+}
@@ -0,0 +1,5 @@
+#include "object.h"
+
+struct node a = {&a, 1, 2};
+
+int main() {}
@@ -0,0 +1,104 @@
+// Copyright 2021 Alex Brachet (alex@brachet.dev)
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "cedo/Backend/AsmStreamer.h"
+#include "cedo/Backend/EmitAsm.h"
+#include "gtest/gtest.h"
+
+template <typename F> static double timeSeconds(F f) {
+  auto start = std::chrono::steady_clock::now();
+  f();
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  return std::chrono::duration<double>(elapsed).count();
+}
+
+// Output goes to a temporary file, its size is how much was emitted.
+struct AsmStreamerBench : public ::testing::Test {
+  std::FILE *file = nullptr;
+  int fd = -1;
+
+  void SetUp() override {
+    file = std::tmpfile();
+    ASSERT_TRUE(file);
+    fd = fileno(file);
+  }
+  void TearDown() override { std::fclose(file); }
+
+  void report(const char *name, double seconds) {
+    size_t bytes = lseek(fd, 0, SEEK_END);
+    std::printf("[ BENCH    ] %s: %.1f MB in %.3f s, %.1f MB/s\n", name,
+                bytes / 1e6, seconds, bytes / 1e6 / seconds);
+  }
+
+  double emit(const Type *type, const void *addr) {
+    std::vector<Sym> syms;
+    syms.emplace_back("table", type, addr);
+    return timeSeconds([&] {
+      AsmEmitter emitter{{FileFormat::ELF, AddressSize::Eight,
+                          Endianness::Little},
+                         fd};
+      emitter.emitAsm(syms);
+      EXPECT_FALSE(emitter.hasFailed());
+    });
+  }
+};
+
+TEST_F(AsmStreamerBench, Directives) {
+  constexpr size_t numLines = 1 << 22;
+  double seconds = timeSeconds([&] {
+    AsmStreamer stream{fd};
+    uint32_t state = 1;
+    for (size_t i = 0; i < numLines; i++) {
+      state = state * 1103515245 + 12345;
+      stream << AsmStreamer::Directive{".long"} << ' ' << state;
+    }
+    stream.flush();
+    EXPECT_FALSE(stream.hasFailed());
+  });
+  report("AsmStreamer .long lines", seconds);
+}
+
+TEST_F(AsmStreamerBench, EmitArray) {
+  constexpr size_t numElements = 1 << 22;
+  std::vector<uint64_t> values(numElements);
+  for (size_t i = 0; i < numElements; i++)
+    values[i] = i * 0x9e3779b97f4a7c15;
+
+  TypeGraph types;
+  const Type *element = types.create<BaseType>(0, 8);
+  double seconds =
+      emit(types.create<ArrayType>(0, element, numElements), values.data());
+  report("AsmEmitter 8 byte array", seconds);
+}
+
+// Text, like a table of names, and bytes which aren't.
+TEST_F(AsmStreamerBench, EmitBytes) {
+  constexpr size_t size = 1 << 25;
+  std::vector<uint8_t> bytes(size);
+  uint32_t state = 1;
+  for (size_t i = 0; i < size; i++) {
+    state = state * 1103515245 + 12345;
+    bytes[i] = i < size / 2 ? 'a' + (state >> 16) % 26 : state >> 16;
+  }
+
+  TypeGraph types;
+  const Type *element = types.create<BaseType>(0, 1);
+  double seconds =
+      emit(types.create<ArrayType>(0, element, size), bytes.data());
+  report("AsmEmitter byte array", seconds);
+}
@@ -23,7 +23,59 @@ TEST(AsmStreamer, PrintBytes) {
   streamer << AsmStreamer::RawBytes{bytes, 4};
   streamer.flush();
 
-  const char *expected = "    .byte 1\n    .byte 2\n    .byte 3\n    .byte 4\n";
+  const char *expected = "    .byte 1, 2, 3, 4\n";
 
   EXPECT_STREQ(output.str().c_str(), expected);
 }
+
+TEST(AsmStreamer, PrintByteLists) {
+  std::stringstream output;
+  AsmStreamer streamer{output};
+
+  uint8_t bytes[20];
+  for (uint8_t i = 0; i < 20; i++)
+    bytes[i] = i;
+  streamer << AsmStreamer::RawBytes{bytes, 20};
+  streamer.flush();
+
+  const char *expected =
+      "    .byte 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15\n"
+      "    .byte 16, 17, 18, 19\n";
+
+  EXPECT_STREQ(output.str().c_str(), expected);
+}
+
+TEST(AsmStreamer, PrintStrings) {
+  std::stringstream output;
+  AsmStreamer streamer{output};
+
+  // Short runs of printable bytes stay as bytes.
+  const char chars[] = "\x01" "ab\x02Say \"hi\"\\\tto\n\x7f\x03"
+                       "a string long enough that it has to be split over more "
+                       "than one line";
+  streamer << AsmStreamer::RawBytes{reinterpret_cast<const uint8_t *>(chars),
+                                    sizeof(chars)};
+  streamer.flush();
+
+  const char *expected =
+      "    .byte 1, 97, 98, 2\n"
+      "    .ascii \"Say \\\"hi\\\"\\\\\\tto\\n\"\n"
+      "    .byte 127, 3\n"
+      "    .ascii \"a string long enough that it has to be split over more "
+      "than one \"\n"
+      "    .string \"line\"\n";
+
+  EXPECT_STREQ(output.str().c_str(), expected);
+}
+
+TEST(AsmStreamer, PrintQuoted) {
+  std::stringstream output;
+  AsmStreamer streamer{output};
+
+  streamer << AsmStreamer::Directive{".incbin"} << ' '
+           << AsmStreamer::Quoted{"dir \"a\"\\b\x01" "1.bin"};
+  streamer.flush();
+
+  EXPECT_STREQ(output.str().c_str(),
+               "    .incbin \"dir \\\"a\\\"\\\\b\\0011.bin\"\n");
+}
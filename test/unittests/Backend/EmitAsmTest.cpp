@@ -9,6 +9,8 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <cstdio>
+#include <cstring>
 #include <memory>
 #include <sstream>
 #include <vector>
@@ -41,11 +43,149 @@ sym8:
   std::stringstream output;
 
   uint8_t bytes[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+  TypeGraph types;
   std::vector<Sym> syms;
-  syms.emplace_back("sym4", std::make_unique<BaseType>(0, 4), bytes);
-  syms.emplace_back("sym8", std::make_unique<BaseType>(0, 8), bytes);
+  syms.emplace_back("sym4", types.create<BaseType>(0, 4), bytes);
+  syms.emplace_back("sym8", types.create<BaseType>(0, 8), bytes);
   AsmEmitter asmEmitter{{FileFormat::ELF, AddressSize::Eight, Endianness::Little}, output};
   asmEmitter.emitAsm(syms);
 
   EXPECT_STREQ(output.str().c_str(), expectedBasicTypes);
 }
+
+TEST(EmitAsm, EmitNestedTypes) {
+  const char *expectedNestedTypes =
+      R"(    .data
+    .type pairs,@object
+    .size pairs, 24
+    .global pairs
+    .align 1
+pairs:
+    .byte 1
+    .zero 3
+    .long 2
+    .byte 3
+    .zero 3
+    .long 4
+    .byte 5
+    .zero 3
+    .long 6
+
+    .type ints,@object
+    .size ints, 12
+    .global ints
+    .align 1
+ints:
+    .long 1, 2, 3
+
+    .type either,@object
+    .size either, 8
+    .global either
+    .align 1
+either:
+    .long 1
+    .zero 4
+
+    .ident "cedo"
+)";
+
+  std::stringstream output;
+
+  uint32_t pairBytes[6] = {1, 2, 3, 4, 5, 6};
+  uint32_t intBytes[3] = {1, 2, 3};
+  TypeGraph types;
+  const Type *byteType = types.create<BaseType>(0, 1);
+  const Type *intType = types.create<BaseType>(0, 4);
+  StructType *pair = types.create<StructType>(0, 8);
+  pair->members = {{byteType, 0}, {intType, 4}};
+  // A union's members share an offset, the largest one is emitted.
+  StructType *either = types.create<StructType>(0, 8);
+  either->members = {{byteType, 0}, {intType, 0}};
+
+  std::vector<Sym> syms;
+  syms.emplace_back("pairs", types.create<ArrayType>(0, pair, 3), pairBytes);
+  syms.emplace_back("ints", types.create<ArrayType>(0, intType, 3), intBytes);
+  syms.emplace_back("either", either, intBytes);
+  AsmEmitter asmEmitter{{FileFormat::ELF, AddressSize::Eight, Endianness::Little}, output};
+  asmEmitter.emitAsm(syms);
+
+  EXPECT_STREQ(output.str().c_str(), expectedNestedTypes);
+}
+
+TEST(EmitAsm, EmitIncbin) {
+  const char *expectedIncbin =
+      R"(    .data
+    .type nodes,@object
+    .size nodes, 176
+    .global nodes
+    .align 1
+nodes:
+    .quad nodes
+    .incbin "sym.bin", 0, 80
+    .quad 0
+    .incbin "sym.bin", 80, 80
+
+    .type table,@object
+    .size table, 128
+    .global table
+    .align 1
+table:
+    .incbin "sym.bin", 160, 128
+
+    .type ints,@object
+    .size ints, 12
+    .global ints
+    .align 1
+ints:
+    .long 1, 2, 3
+
+    .ident "cedo"
+)";
+
+  struct Node {
+    const void *next;
+    uint32_t values[20];
+  } nodes[2];
+  nodes[0].next = nodes;
+  nodes[1].next = nullptr;
+  uint32_t table[32];
+  for (uint32_t i = 0; i < 20; i++) {
+    nodes[0].values[i] = i;
+    nodes[1].values[i] = i + 20;
+  }
+  for (uint32_t i = 0; i < 32; i++)
+    table[i] = i * i;
+  uint32_t ints[3] = {1, 2, 3};
+
+  TypeGraph types;
+  const Type *intType = types.create<BaseType>(0, 4);
+  StructType *node = types.create<StructType>(0, sizeof(Node));
+  node->members = {{types.create<PointerType>(0, node), 0},
+                   {types.create<ArrayType>(0, intType, 20), 8}};
+
+  std::vector<Sym> syms;
+  syms.emplace_back("nodes", types.create<ArrayType>(0, node, 2), nodes);
+  syms.emplace_back("table", types.create<ArrayType>(0, intType, 32), table);
+  syms.emplace_back("ints", types.create<ArrayType>(0, intType, 3), ints);
+
+  std::stringstream output;
+  std::unique_ptr<FILE, int (*)(FILE *)> incbinFile{std::tmpfile(),
+                                                   std::fclose};
+  ASSERT_TRUE(incbinFile);
+  AsmEmitter asmEmitter{{FileFormat::ELF, AddressSize::Eight, Endianness::Little}, output};
+  asmEmitter.setIncbinFile(fileno(incbinFile.get()), "sym.bin", 64);
+  asmEmitter.emitAsm(syms);
+  ASSERT_FALSE(asmEmitter.hasFailed());
+
+  EXPECT_STREQ(output.str().c_str(), expectedIncbin);
+
+  // The included bytes are the objects' own.
+  uint8_t expected[288], included[289];
+  std::memcpy(expected, nodes[0].values, 80);
+  std::memcpy(expected + 80, nodes[1].values, 80);
+  std::memcpy(expected + 160, table, 128);
+  std::rewind(incbinFile.get());
+  ASSERT_EQ(std::fread(included, 1, sizeof(included), incbinFile.get()),
+            sizeof(expected));
+  EXPECT_EQ(std::memcmp(included, expected, sizeof(expected)), 0);
+}
@@ -0,0 +1,141 @@
+// Copyright 2021 Alex Brachet (alex@brachet.dev)
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <elf.h>
+
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "cedo/Backend/EmitObject.h"
+
+#include "gtest/gtest.h"
+
+namespace {
+
+// Reads back the sections of an ELF64 object by name.
+struct ObjectReader {
+  std::string file;
+  const Elf64_Ehdr *ehdr;
+  const Elf64_Shdr *shdrs;
+
+  ObjectReader(std::string file) : file(std::move(file)) {
+    ehdr = reinterpret_cast<const Elf64_Ehdr *>(this->file.data());
+    shdrs = reinterpret_cast<const Elf64_Shdr *>(this->file.data() +
+                                                 ehdr->e_shoff);
+  }
+
+  std::string_view getName(const Elf64_Shdr &strtab, uint32_t offset) const {
+    return file.data() + strtab.sh_offset + offset;
+  }
+
+  const Elf64_Shdr *findSection(std::string_view name) const {
+    for (size_t i = 0; i < ehdr->e_shnum; i++)
+      if (getName(shdrs[ehdr->e_shstrndx], shdrs[i].sh_name) == name)
+        return &shdrs[i];
+    return nullptr;
+  }
+
+  std::string_view getContents(const Elf64_Shdr &shdr) const {
+    return {file.data() + shdr.sh_offset, shdr.sh_size};
+  }
+};
+
+} // namespace
+
+TEST(EmitObject, EmitELF64) {
+  struct Node {
+    uint8_t tag;
+    const void *next;
+  } nodes[2] = {{1, nullptr}, {2, nullptr}};
+  nodes[1].next = &nodes[0];
+  uint32_t ints[3] = {1, 2, 3};
+
+  TypeGraph types;
+  StructType *node = types.create<StructType>(0, sizeof(Node));
+  node->members = {{types.create<BaseType>(0, 1), 0},
+                   {types.create<PointerType>(0, node), 8}};
+  std::vector<Sym> syms;
+  syms.emplace_back("ints",
+                    types.create<ArrayType>(0, types.create<BaseType>(0, 4), 3),
+                    ints);
+  syms.emplace_back("nodes", types.create<ArrayType>(0, node, 2), nodes);
+
+  std::stringstream output;
+  ObjectEmitter objectEmitter{
+      {FileFormat::ELF, AddressSize::Eight, Endianness::Little}, output};
+  ASSERT_FALSE(objectEmitter.emitObjectFile(syms, "1.0"));
+  ASSERT_FALSE(objectEmitter.hasFailed());
+
+  ObjectReader reader{output.str()};
+  EXPECT_EQ(std::memcmp(reader.ehdr->e_ident, ELFMAG, SELFMAG), 0);
+  EXPECT_EQ(reader.ehdr->e_ident[EI_CLASS], ELFCLASS64);
+  EXPECT_EQ(reader.ehdr->e_ident[EI_DATA], ELFDATA2LSB);
+  EXPECT_EQ(reader.ehdr->e_type, ET_REL);
+  EXPECT_EQ(reader.ehdr->e_machine, EM_X86_64);
+
+  // Padding and pointers are zeros, pointers are filled in by relocations.
+  const Elf64_Shdr *data = reader.findSection(".data");
+  ASSERT_TRUE(data);
+  uint8_t expectedData[12 + 32] = {1, 0, 0, 0, 2, 0, 0, 0, 3, 0, 0, 0};
+  expectedData[12] = 1;
+  expectedData[12 + 16] = 2;
+  EXPECT_EQ(reader.getContents(*data),
+            std::string_view(reinterpret_cast<const char *>(expectedData),
+                             sizeof(expectedData)));
+
+  const Elf64_Shdr *symtab = reader.findSection(".symtab");
+  ASSERT_TRUE(symtab);
+  ASSERT_EQ(symtab->sh_size, 3 * sizeof(Elf64_Sym));
+  const auto *elfSyms = reinterpret_cast<const Elf64_Sym *>(
+      reader.getContents(*symtab).data());
+  const Elf64_Shdr &strtab = reader.shdrs[symtab->sh_link];
+  EXPECT_EQ(reader.getName(strtab, elfSyms[1].st_name), "ints");
+  EXPECT_EQ(elfSyms[1].st_value, 0u);
+  EXPECT_EQ(elfSyms[1].st_size, 12u);
+  EXPECT_EQ(reader.getName(strtab, elfSyms[2].st_name), "nodes");
+  EXPECT_EQ(elfSyms[2].st_value, 12u);
+  EXPECT_EQ(elfSyms[2].st_size, 32u);
+  EXPECT_EQ(ELF64_ST_BIND(elfSyms[2].st_info), STB_GLOBAL);
+  EXPECT_EQ(ELF64_ST_TYPE(elfSyms[2].st_info), STT_OBJECT);
+
+  // Only the pointer that isn't null is relocated.
+  const Elf64_Shdr *rela = reader.findSection(".rela.data");
+  ASSERT_TRUE(rela);
+  ASSERT_EQ(rela->sh_size, sizeof(Elf64_Rela));
+  const auto *relocs = reinterpret_cast<const Elf64_Rela *>(
+      reader.getContents(*rela).data());
+  EXPECT_EQ(relocs[0].r_offset, 12u + 16 + 8);
+  EXPECT_EQ(ELF64_R_TYPE(relocs[0].r_info), R_X86_64_64);
+  EXPECT_EQ(ELF64_R_SYM(relocs[0].r_info), 2u);
+  EXPECT_EQ(relocs[0].r_addend, 0);
+
+  const Elf64_Shdr *comment = reader.findSection(".comment");
+  ASSERT_TRUE(comment);
+  using namespace std::string_view_literals;
+  EXPECT_EQ(reader.getContents(*comment), "\0cedo 1.0\0"sv);
+}
+
+TEST(EmitObject, BigEndian) {
+  uint32_t value = 1;
+  TypeGraph types;
+  std::vector<Sym> syms;
+  syms.emplace_back("value", types.create<BaseType>(0, 4), &value);
+
+  std::stringstream output;
+  ObjectEmitter objectEmitter{
+      {FileFormat::ELF, AddressSize::Eight, Endianness::Big}, output};
+  Error err = objectEmitter.emitObjectFile(syms);
+  EXPECT_EQ(err.getCode(), Error::Code::Unsupported);
+  EXPECT_TRUE(output.str().empty());
+}
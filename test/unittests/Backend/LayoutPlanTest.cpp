@@ -0,0 +1,75 @@
+// Copyright 2021 Alex Brachet (alex@brachet.dev)
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cedo/Backend/LayoutPlan.h"
+
+#include "gtest/gtest.h"
+
+using Step = LayoutPlan::Step;
+
+struct LayoutPlanTest : public ::testing::Test {
+  TypeGraph types;
+  const Type *byteType = types.create<BaseType>(0, 1);
+  const Type *intType = types.create<BaseType>(0, 4);
+
+  static void expectStep(const Step &step, Step::Kind kind, uint64_t offset,
+                         int64_t size, uint64_t count) {
+    EXPECT_EQ(step.kind, kind);
+    EXPECT_EQ(step.offset, offset);
+    EXPECT_EQ(step.size, size);
+    EXPECT_EQ(step.count, count);
+  }
+};
+
+// Arrays of scalars and structs of them without padding are one run, however
+// many elements they have.
+TEST_F(LayoutPlanTest, CoalescesValues) {
+  StructType *quad = types.create<StructType>(0, 16);
+  quad->members = {{intType, 0}, {intType, 4}, {intType, 8}, {intType, 12}};
+  LayoutPlan plan =
+      LayoutPlan::compile(*types.create<ArrayType>(0, quad, 1 << 20));
+  ASSERT_EQ(plan.steps.size(), 1u);
+  expectStep(plan.steps[0], Step::Values, 0, 4, 4 << 20);
+}
+
+TEST_F(LayoutPlanTest, RepeatsElements) {
+  StructType *pair = types.create<StructType>(0, 16);
+  pair->members = {{byteType, 0},
+                   {types.create<PointerType>(0, nullptr), 8}};
+  StructType *outer = types.create<StructType>(0, 8 + 16 * 100);
+  outer->members = {{intType, 0},
+                    {intType, 4},
+                    {types.create<ArrayType>(0, pair, 100), 8}};
+
+  LayoutPlan plan = LayoutPlan::compile(*outer);
+  ASSERT_EQ(plan.steps.size(), 5u);
+  expectStep(plan.steps[0], Step::Values, 0, 4, 2);
+  expectStep(plan.steps[1], Step::Repeat, 8, 16, 100);
+  EXPECT_EQ(plan.steps[1].numSteps, 3u);
+  EXPECT_TRUE(plan.steps[1].hasPointers);
+  expectStep(plan.steps[2], Step::Values, 0, 1, 1);
+  expectStep(plan.steps[3], Step::Padding, 1, 7, 1);
+  expectStep(plan.steps[4], Step::Pointer, 8, 8, 1);
+}
+
+// Values after a Repeat aren't merged into its last element.
+TEST_F(LayoutPlanTest, ValuesAfterRepeat) {
+  StructType *pair = types.create<StructType>(0, 8);
+  pair->members = {{byteType, 0}, {intType, 4}};
+  StructType *outer = types.create<StructType>(0, 20);
+  outer->members = {{types.create<ArrayType>(0, pair, 2), 0}, {intType, 16}};
+
+  LayoutPlan plan = LayoutPlan::compile(*outer);
+  ASSERT_EQ(plan.steps.size(), 5u);
+  expectStep(plan.steps[0], Step::Repeat, 0, 8, 2);
+  expectStep(plan.steps[3], Step::Values, 4, 4, 1);
+  expectStep(plan.steps[4], Step::Values, 16, 4, 1);
+}
@@ -0,0 +1,128 @@
+// Copyright 2021 Alex Brachet (alex@brachet.dev)
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+
+#include "cedo/Binfmt/Binfmt.h"
+#include "cedo/Binfmt/DWARF.h"
+#include "cedo/Core/FileReader.h"
+#include "gtest/gtest.h"
+
+// Types.c built with -gdwarf-5. Types.o's strings come from relocations,
+// Types.so's are offsets into .debug_str and .debug_line_str.
+struct DWARF5 : public ::testing::TestWithParam<const char *> {
+  std::unique_ptr<ObjectFileReader> objFileReader;
+  DWARF dwarf;
+
+  void SetUp() override {
+    ErrorOr<FileReader> fileReaderOrErr = FileReader::open(GetParam());
+    ASSERT_TRUE(fileReaderOrErr);
+
+    objFileReader = createObjectFileReader(std::move(*fileReaderOrErr));
+    ASSERT_NE(objFileReader, nullptr);
+
+    ErrorOr<DWARF> dwarfOrErr = DWARF::readFromObject(*objFileReader);
+    ASSERT_TRUE(dwarfOrErr) << dwarfOrErr.getError();
+
+    dwarf = std::move(*dwarfOrErr);
+  }
+
+  template <typename DIE>
+  static std::string_view getString(const DIE &die, DW_AT attr) {
+    auto value = die.getAttributeIfPresent(attr);
+    return value ? std::get<std::string_view>(*value) : std::string_view{};
+  }
+};
+
+TEST_P(DWARF5, ReadBasicType) {
+  auto expectVarSize = [&](std::string_view sym_name, size_t size) {
+    const Type *type = dwarf.getVariableType(sym_name);
+    if (!type) {
+      EXPECT_TRUE(false) << "Couldn't find symbol: " << sym_name;
+      return;
+    }
+    EXPECT_EQ(type->getObjectSize(), size);
+  };
+
+  expectVarSize("one", 1);
+  expectVarSize("two", 2);
+  expectVarSize("four", 4);
+  expectVarSize("eight", 8);
+}
+
+TEST_P(DWARF5, LineStrings) {
+  const auto &compileUnitDIE = dwarf.getDebugInfo()[0];
+  ASSERT_EQ(compileUnitDIE.tag, DW_TAG_compile_unit);
+  EXPECT_NE(getString(compileUnitDIE, DW_AT_name).find("Types.c"),
+            std::string_view::npos);
+  EXPECT_FALSE(getString(compileUnitDIE, DW_AT_comp_dir).empty());
+}
+
+// The first string in .debug_str has offset 0, which in a relocatable object
+// would mean a relocation fills it in.
+TEST_P(DWARF5, EveryStringResolves) {
+  for (const auto &die : dwarf.getDebugInfo()) {
+    if (die.tag == DW_TAG_base_type || die.tag == DW_TAG_variable ||
+        die.tag == DW_TAG_member) {
+      EXPECT_FALSE(getString(die, DW_AT_name).empty())
+          << "DIE at offset " << die.offset << " has no name";
+    }
+  }
+}
+
+// Bit fields have a DW_AT_data_bit_offset instead of a
+// DW_AT_data_member_location.
+TEST_P(DWARF5, BitFields) {
+  const auto *bits =
+      dynamic_cast<const StructType *>(dwarf.getVariableType("bits"));
+  ASSERT_TRUE(bits);
+  EXPECT_EQ(bits->getObjectSize(), 16u);
+  ASSERT_EQ(bits->members.size(), 4u);
+  EXPECT_EQ(bits->members[2].second, 0);
+  EXPECT_EQ(bits->members[3].second, 8);
+}
+
+INSTANTIATE_TEST_SUITE_P(Inputs, DWARF5,
+                         ::testing::Values("Inputs/DWARF5/Types.o",
+                                           "Inputs/DWARF5/Types.so"));
+
+// The units from MultiUnit in .dwo files, with their strings in
+// .debug_str_offsets.dwo tables.
+TEST(DWARF5Split, SplitUnits) {
+  DebugFileOptions options;
+  options.objectPath = "Inputs/DWARF5/Split.so";
+  ErrorOr<FileReader> fileReaderOrErr = FileReader::open(options.objectPath);
+  ASSERT_TRUE(fileReaderOrErr);
+  std::unique_ptr<ObjectFileReader> objFileReader =
+      createObjectFileReader(std::move(*fileReaderOrErr));
+  ASSERT_NE(objFileReader, nullptr);
+
+  ErrorOr<DWARF> dwarfOrErr =
+      DWARF::readFromObject(*objFileReader, DWARF::ParseMode::Full, options);
+  ASSERT_TRUE(dwarfOrErr) << dwarfOrErr.getError();
+
+  const auto &debugInfo = dwarfOrErr->getDebugInfo();
+  EXPECT_EQ(std::count_if(debugInfo.begin(), debugInfo.end(),
+                          [](const auto &die) {
+                            return die.tag == DW_TAG_compile_unit;
+                          }),
+            2);
+
+  auto expectVarSize = [&](std::string_view name, size_t size) {
+    const Type *type = dwarfOrErr->getVariableType(name);
+    ASSERT_TRUE(type) << "Couldn't find symbol: " << name;
+    EXPECT_EQ(type->getObjectSize(), size);
+  };
+  expectVarSize("first", 4);
+  expectVarSize("pair", 16);
+  expectVarSize("second", 2);
+  expectVarSize("otherPair", 4);
+}
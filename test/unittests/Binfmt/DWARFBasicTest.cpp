@@ -15,6 +15,8 @@
 #include "gtest/gtest.h"
 
 struct DWARFBasic : public ::testing::Test {
+  // DWARF has views into the object file so it needs to stay mapped.
+  std::unique_ptr<ObjectFileReader> objFileReader;
   DWARF dwarf;
 
   void SetUp() override {
@@ -22,8 +24,7 @@ struct DWARFBasic : public ::testing::Test {
         FileReader::open("Inputs/BasicTypes.o");
     ASSERT_TRUE(fileReaderOrErr);
 
-    std::unique_ptr<ObjectFileReader> objFileReader =
-        createObjectFileReader(std::move(*fileReaderOrErr));
+    objFileReader = createObjectFileReader(std::move(*fileReaderOrErr));
     ASSERT_NE(objFileReader, nullptr);
 
     ErrorOr<DWARF> dwarfOrErr = DWARF::readFromObject(*objFileReader);
@@ -35,7 +36,7 @@ struct DWARFBasic : public ::testing::Test {
 
 TEST_F(DWARFBasic, ReadBasicType) {
   auto expectVarSize = [&](std::string_view sym_name, size_t size) {
-    std::unique_ptr<Type> type = dwarf.getVariableType(sym_name);
+    const Type *type = dwarf.getVariableType(sym_name);
     if (!type) {
       EXPECT_TRUE(false) << "Couldn't find symbol: " << sym_name;
       return;
@@ -54,6 +55,40 @@ TEST_F(DWARFBasic, ReadBasicType) {
 TEST_F(DWARFBasic, ChildDIEs) {
   const auto &compileUnitDIE = dwarf.getDebugInfo()[0];
   ASSERT_EQ(compileUnitDIE.tag, DW_TAG_compile_unit);
-  EXPECT_EQ(compileUnitDIE.childrenOffsets.size(),
-            dwarf.getDebugInfo().size() - 1);
+  size_t numChildren = 0;
+  for (const auto &child : compileUnitDIE.children())
+    EXPECT_EQ(&child, &dwarf.getDebugInfo()[++numChildren]);
+  EXPECT_EQ(numChildren, dwarf.getDebugInfo().size() - 1);
+}
+
+TEST_F(DWARFBasic, StringsPointIntoObjectFile) {
+  const auto &compileUnitDIE = dwarf.getDebugInfo()[0];
+  auto name = compileUnitDIE.getAttributeIfPresent(DW_AT_name);
+  ASSERT_TRUE(name);
+  std::string_view nameStr = std::get<std::string_view>(*name);
+  EXPECT_NE(nameStr.find("BasicTypes.c"), std::string_view::npos);
+
+  const FileReader &file = objFileReader->getFileReader();
+  EXPECT_GE(nameStr.data(), file.getFileBuffer());
+  EXPECT_LT(nameStr.data(), file.getFileBuffer() + file.getFileSize());
+}
+
+TEST(DWARFAbbrevs, ULEB128AndSparseCodes) {
+  ErrorOr<FileReader> fileReaderOrErr = FileReader::open("Inputs/Abbrevs.o");
+  ASSERT_TRUE(fileReaderOrErr);
+  std::unique_ptr<ObjectFileReader> objFileReader =
+      createObjectFileReader(std::move(*fileReaderOrErr));
+  ASSERT_NE(objFileReader, nullptr);
+
+  ErrorOr<DWARF> dwarfOrErr = DWARF::readFromObject(*objFileReader);
+  ASSERT_TRUE(dwarfOrErr) << dwarfOrErr.getError();
+
+  const auto &debugInfo = dwarfOrErr->getDebugInfo();
+  ASSERT_EQ(debugInfo.size(), 3u);
+  EXPECT_EQ(debugInfo[2].tag, DW_TAG_base_type);
+  EXPECT_TRUE(debugInfo[2].getAttributeIfPresent(DW_AT{0x2107}));
+
+  const Type *type = dwarfOrErr->getVariableType("v");
+  ASSERT_TRUE(type);
+  EXPECT_EQ(type->getObjectSize(), 4u);
 }
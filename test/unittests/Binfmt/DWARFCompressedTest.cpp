@@ -0,0 +1,149 @@
+// Copyright 2021 Alex Brachet (alex@brachet.dev)
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <elf.h>
+#include <unistd.h>
+
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "cedo/Binfmt/Binfmt.h"
+#include "cedo/Binfmt/DWARF.h"
+#include "cedo/Core/FileReader.h"
+#include "lib/Binfmt/ELF.h"
+#include "gtest/gtest.h"
+
+static std::unique_ptr<ELF::Reader> open(std::string_view path) {
+  ErrorOr<FileReader> fileReaderOrErr = FileReader::open(path);
+  if (!fileReaderOrErr)
+    return nullptr;
+  return ELF::Reader::create(std::move(*fileReaderOrErr));
+}
+
+struct DWARFCompressed : public ::testing::TestWithParam<const char *> {};
+
+TEST_P(DWARFCompressed, SameAsUncompressed) {
+  std::unique_ptr<ELF::Reader> uncompressed = open("Inputs/BasicTypes.o");
+  std::unique_ptr<ELF::Reader> compressed = open(GetParam());
+  ASSERT_NE(uncompressed, nullptr);
+  ASSERT_NE(compressed, nullptr);
+
+  ELF::Section expected = uncompressed->getSection(".debug_info");
+  ELF::Section section = compressed->getSection(".debug_info");
+  ASSERT_TRUE(section);
+  ASSERT_EQ(section.size, expected.size);
+  EXPECT_EQ(std::string_view(reinterpret_cast<const char *>(section.data),
+                             section.size),
+            std::string_view(reinterpret_cast<const char *>(expected.data),
+                             expected.size));
+  // Decompressed once.
+  EXPECT_EQ(compressed->getSection(".debug_info").data, section.data);
+}
+
+TEST_P(DWARFCompressed, ReadBasicType) {
+  std::unique_ptr<ELF::Reader> objFileReader = open(GetParam());
+  ASSERT_NE(objFileReader, nullptr);
+  ErrorOr<DWARF> dwarfOrErr = DWARF::readFromObject(*objFileReader);
+  ASSERT_TRUE(dwarfOrErr) << dwarfOrErr.getError();
+
+  auto expectVarSize = [&](std::string_view name, size_t size) {
+    const Type *type = dwarfOrErr->getVariableType(name);
+    ASSERT_TRUE(type) << "Couldn't find symbol: " << name;
+    EXPECT_EQ(type->getObjectSize(), size);
+  };
+  expectVarSize("one", 1);
+  expectVarSize("two", 2);
+  expectVarSize("four", 4);
+  expectVarSize("eight", 8);
+}
+
+// .zdebug_* sections are found by their .debug_* name, and names too short to
+// be one are compared without slicing past their end.
+TEST(DWARFCompressedGNU, GetSections) {
+  std::unique_ptr<ELF::Reader> objFileReader =
+      open("Inputs/BasicTypesZlibGNU.o");
+  ASSERT_NE(objFileReader, nullptr);
+  std::vector<ELF::Section> sections =
+      objFileReader->getSections(".debug_info");
+  ASSERT_EQ(sections.size(), 1u);
+  EXPECT_TRUE(sections[0]);
+  EXPECT_TRUE(objFileReader->getSections(".d").empty());
+  EXPECT_TRUE(objFileReader->getSections(".debug").empty());
+}
+
+INSTANTIATE_TEST_SUITE_P(Zlib, DWARFCompressed,
+                         ::testing::Values("Inputs/BasicTypesZlib.o",
+                                           "Inputs/BasicTypesZlibGNU.o"));
+
+TEST(DWARFCompressedMultiUnit, ReadBothUnits) {
+  std::unique_ptr<ELF::Reader> objFileReader =
+      open("Inputs/MultiUnitZlib.so");
+  ASSERT_NE(objFileReader, nullptr);
+  ErrorOr<DWARF> dwarfOrErr = DWARF::readFromObject(*objFileReader);
+  ASSERT_TRUE(dwarfOrErr) << dwarfOrErr.getError();
+  const Type *first = dwarfOrErr->getVariableType("first");
+  const Type *second = dwarfOrErr->getVariableType("second");
+  ASSERT_TRUE(first);
+  ASSERT_TRUE(second);
+  EXPECT_EQ(first->getObjectSize(), 4u);
+  EXPECT_EQ(second->getObjectSize(), 2u);
+}
+
+// Writes Inputs/BasicTypesZlib.o with .debug_info's recorded uncompressed size
+// changed, and opens it.
+static std::unique_ptr<ELF::Reader> openWithSize(uint64_t (*getSize)(uint64_t),
+                                                 std::string &path) {
+  ErrorOr<FileReader> fileReaderOrErr =
+      FileReader::open("Inputs/BasicTypesZlib.o");
+  if (!fileReaderOrErr)
+    return nullptr;
+  std::string contents{fileReaderOrErr->getFileBuffer(),
+                       fileReaderOrErr->getFileSize()};
+  const auto *ehdr = reinterpret_cast<const Elf64_Ehdr *>(contents.data());
+  const auto *shdrs =
+      reinterpret_cast<const Elf64_Shdr *>(contents.data() + ehdr->e_shoff);
+  const char *names = contents.data() + shdrs[ehdr->e_shstrndx].sh_offset;
+  for (size_t i = 0; i < ehdr->e_shnum; i++) {
+    if (std::string_view{names + shdrs[i].sh_name} != ".debug_info")
+      continue;
+    auto *chdr =
+        reinterpret_cast<Elf64_Chdr *>(contents.data() + shdrs[i].sh_offset);
+    chdr->ch_size = getSize(chdr->ch_size);
+  }
+
+  const char *tmpDir = std::getenv("TMPDIR");
+  path = std::string{tmpDir && *tmpDir ? tmpDir : "/tmp"} +
+         "/cedo-compressed-XXXXXX";
+  int fd = ::mkstemp(path.data());
+  if (fd < 0)
+    return nullptr;
+  bool written = ::write(fd, contents.data(), contents.size()) ==
+                 static_cast<ssize_t>(contents.size());
+  ::close(fd);
+  std::unique_ptr<ELF::Reader> reader = written ? open(path) : nullptr;
+  ::unlink(path.c_str());
+  return reader;
+}
+
+// Sizes that don't match the compressed data leave the section empty, without
+// allocating what a corrupt size asks for.
+TEST(DWARFCompressedMalformed, WrongUncompressedSize) {
+  std::string path;
+  for (auto getSize : {+[](uint64_t) -> uint64_t { return 1ull << 60; },
+                       +[](uint64_t size) { return size * 2; },
+                       +[](uint64_t size) { return size - 1; }}) {
+    std::unique_ptr<ELF::Reader> objFileReader = openWithSize(getSize, path);
+    ASSERT_NE(objFileReader, nullptr);
+    EXPECT_FALSE(objFileReader->getSection(".debug_info"));
+    EXPECT_TRUE(objFileReader->getSection(".debug_abbrev"));
+  }
+}
@@ -0,0 +1,69 @@
+// Copyright 2021 Alex Brachet (alex@brachet.dev)
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+
+#include "cedo/Binfmt/Binfmt.h"
+#include "cedo/Binfmt/DWARF.h"
+#include "cedo/Core/FileReader.h"
+#include "gtest/gtest.h"
+
+// MultiUnit.so is linked, MultiUnit.o is from ld -r where the units' abbrev
+// offsets are relocations.
+struct DWARFMultiUnit : public ::testing::TestWithParam<const char *> {
+  std::unique_ptr<ObjectFileReader> objFileReader;
+  DWARF dwarf;
+
+  void SetUp() override {
+    ErrorOr<FileReader> fileReaderOrErr = FileReader::open(GetParam());
+    ASSERT_TRUE(fileReaderOrErr);
+
+    objFileReader = createObjectFileReader(std::move(*fileReaderOrErr));
+    ASSERT_NE(objFileReader, nullptr);
+
+    ErrorOr<DWARF> dwarfOrErr = DWARF::readFromObject(*objFileReader);
+    ASSERT_TRUE(dwarfOrErr) << dwarfOrErr.getError();
+
+    dwarf = std::move(*dwarfOrErr);
+  }
+
+  void expectVarSize(std::string_view sym_name, size_t size) {
+    const Type *type = dwarf.getVariableType(sym_name);
+    if (!type) {
+      EXPECT_TRUE(false) << "Couldn't find symbol: " << sym_name;
+      return;
+    }
+    EXPECT_EQ(type->getObjectSize(), size);
+  }
+};
+
+TEST_P(DWARFMultiUnit, ReadsEveryUnit) {
+  const auto &debugInfo = dwarf.getDebugInfo();
+  EXPECT_EQ(std::count_if(debugInfo.begin(), debugInfo.end(),
+                          [](const auto &die) {
+                            return die.tag == DW_TAG_compile_unit;
+                          }),
+            2);
+  EXPECT_TRUE(std::is_sorted(
+      debugInfo.begin(), debugInfo.end(),
+      [](const auto &a, const auto &b) { return a.offset < b.offset; }));
+}
+
+TEST_P(DWARFMultiUnit, UnitRelativeTypes) {
+  expectVarSize("first", 4);
+  expectVarSize("pair", 16);
+  expectVarSize("second", 2);
+  expectVarSize("otherPair", 4);
+}
+
+INSTANTIATE_TEST_SUITE_P(Inputs, DWARFMultiUnit,
+                         ::testing::Values("Inputs/MultiUnit.so",
+                                           "Inputs/MultiUnit.o"));
@@ -0,0 +1,71 @@
+// Copyright 2021 Alex Brachet (alex@brachet.dev)
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cedo/Binfmt/Binfmt.h"
+#include "cedo/Binfmt/DWARF.h"
+#include "cedo/Core/FileReader.h"
+#include "gtest/gtest.h"
+
+struct DWARFNameIndex : public ::testing::Test {
+  std::unique_ptr<ObjectFileReader> objFileReader;
+  DWARF dwarf;
+
+  void SetUp() override {
+    ErrorOr<FileReader> fileReaderOrErr =
+        FileReader::open("Inputs/Namespaces.o");
+    ASSERT_TRUE(fileReaderOrErr);
+
+    objFileReader = createObjectFileReader(std::move(*fileReaderOrErr));
+    ASSERT_NE(objFileReader, nullptr);
+
+    ErrorOr<DWARF> dwarfOrErr = DWARF::readFromObject(*objFileReader);
+    ASSERT_TRUE(dwarfOrErr) << dwarfOrErr.getError();
+
+    dwarf = std::move(*dwarfOrErr);
+  }
+
+  void expectVarSize(std::string_view sym_name, size_t size) {
+    const Type *type = dwarf.getVariableType(sym_name);
+    if (!type) {
+      EXPECT_TRUE(false) << "Couldn't find symbol: " << sym_name;
+      return;
+    }
+    EXPECT_EQ(type->getObjectSize(), size);
+  }
+};
+
+TEST_F(DWARFNameIndex, QualifiedNames) {
+  expectVarSize("ns::table", 4);
+  expectVarSize("ns::inner::value", 8);
+  expectVarSize("S::member", 2);
+  expectVarSize("global", 4);
+
+  EXPECT_FALSE(dwarf.getVariableType("inner::value"));
+  EXPECT_FALSE(dwarf.getVariableType("ns::global"));
+}
+
+TEST_F(DWARFNameIndex, UnqualifiedNames) {
+  expectVarSize("table", 4);
+  expectVarSize("value", 8);
+  expectVarSize("member", 2);
+}
+
+TEST_F(DWARFNameIndex, LinkageNames) {
+  expectVarSize("_ZN2ns5tableE", 4);
+  expectVarSize("_ZN2ns5inner5valueE", 8);
+  expectVarSize("_ZN1S6memberE", 2);
+
+  EXPECT_EQ(dwarf.getVariableLinkageName("ns::table"), "_ZN2ns5tableE");
+  EXPECT_EQ(dwarf.getVariableLinkageName("value"), "_ZN2ns5inner5valueE");
+  EXPECT_EQ(dwarf.getVariableLinkageName("S::member"), "_ZN1S6memberE");
+  EXPECT_EQ(dwarf.getVariableLinkageName("global"), "global");
+  EXPECT_EQ(dwarf.getVariableLinkageName("doesnt_exist"), "");
+}
@@ -0,0 +1,72 @@
+// Copyright 2021 Alex Brachet (alex@brachet.dev)
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cedo/Binfmt/Binfmt.h"
+#include "cedo/Binfmt/DWARF.h"
+#include "cedo/Core/FileReader.h"
+#include "gtest/gtest.h"
+
+struct DWARFSelective : public ::testing::Test {
+  std::unique_ptr<ObjectFileReader> objFileReader;
+
+  void SetUp() override {
+    ErrorOr<FileReader> fileReaderOrErr =
+        FileReader::open("Inputs/Functions.o");
+    ASSERT_TRUE(fileReaderOrErr);
+
+    objFileReader = createObjectFileReader(std::move(*fileReaderOrErr));
+    ASSERT_NE(objFileReader, nullptr);
+  }
+
+  DWARF read(DWARF::ParseMode mode) {
+    ErrorOr<DWARF> dwarfOrErr = DWARF::readFromObject(*objFileReader, mode);
+    EXPECT_TRUE(dwarfOrErr) << dwarfOrErr.getError();
+    return dwarfOrErr ? std::move(*dwarfOrErr) : DWARF{};
+  }
+};
+
+TEST_F(DWARFSelective, SkipsFunctions) {
+  DWARF full = read(DWARF::ParseMode::Full);
+  DWARF selective = read(DWARF::ParseMode::VariablesAndTypes);
+  ASSERT_FALSE(selective.getDebugInfo().empty());
+  EXPECT_LT(selective.getDebugInfo().size(), full.getDebugInfo().size());
+
+  for (const auto &die : selective.getDebugInfo()) {
+    EXPECT_NE(die.tag, DW_TAG_subprogram);
+    EXPECT_NE(die.tag, DW_TAG_lexical_block);
+    EXPECT_NE(die.tag, DW_TAG_formal_parameter);
+  }
+
+  // Only the global variables and the compile unit's own children are left.
+  const auto &compileUnitDIE = selective.getDebugInfo()[0];
+  size_t numChildren = 0;
+  for (const auto &child : compileUnitDIE.children()) {
+    (void)child;
+    numChildren++;
+  }
+  EXPECT_EQ(numChildren, selective.getDebugInfo().size() - 1 -
+                             /*Point's members*/ 2);
+}
+
+TEST_F(DWARFSelective, FindsGlobals) {
+  DWARF dwarf = read(DWARF::ParseMode::VariablesAndTypes);
+
+  const Type *counter = dwarf.getVariableType("counter");
+  ASSERT_TRUE(counter);
+  // Not sum's static long counter.
+  EXPECT_EQ(counter->getObjectSize(), 2u);
+
+  const Type *origin = dwarf.getVariableType("origin");
+  ASSERT_TRUE(origin);
+  EXPECT_EQ(origin->getObjectSize(), 8u);
+
+  EXPECT_FALSE(dwarf.getVariableType("total"));
+}
@@ -0,0 +1,94 @@
+// Copyright 2021 Alex Brachet (alex@brachet.dev)
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+
+#include "cedo/Binfmt/Binfmt.h"
+#include "cedo/Binfmt/DWARF.h"
+#include "cedo/Core/FileReader.h"
+#include "gtest/gtest.h"
+
+// The units from MultiUnit built with -gsplit-dwarf. Split.so's units are in
+// .dwo files and SplitPackage.so's are in SplitPackage.so.dwp.
+struct DWARFSplit : public ::testing::TestWithParam<const char *> {
+  std::unique_ptr<ObjectFileReader> objFileReader;
+  DebugFileOptions options;
+
+  void SetUp() override {
+    options.objectPath = GetParam();
+    ErrorOr<FileReader> fileReaderOrErr = FileReader::open(options.objectPath);
+    ASSERT_TRUE(fileReaderOrErr);
+
+    objFileReader = createObjectFileReader(std::move(*fileReaderOrErr));
+    ASSERT_NE(objFileReader, nullptr);
+  }
+
+  static size_t numSplitUnits(const DWARF &dwarf) {
+    const auto &debugInfo = dwarf.getDebugInfo();
+    return std::count_if(debugInfo.begin(), debugInfo.end(),
+                         [](const auto &die) {
+                           return die.tag == DW_TAG_compile_unit &&
+                                  !die.getAttributeIfPresent(
+                                      DW_AT_GNU_dwo_name);
+                         });
+  }
+};
+
+TEST_P(DWARFSplit, UnitRelativeTypes) {
+  ErrorOr<DWARF> dwarfOrErr =
+      DWARF::readFromObject(*objFileReader, DWARF::ParseMode::Full, options);
+  ASSERT_TRUE(dwarfOrErr) << dwarfOrErr.getError();
+  EXPECT_EQ(numSplitUnits(*dwarfOrErr), 2u);
+
+  auto expectVarSize = [&](std::string_view name, size_t size) {
+    const Type *type = dwarfOrErr->getVariableType(name);
+    ASSERT_TRUE(type) << "Couldn't find symbol: " << name;
+    EXPECT_EQ(type->getObjectSize(), size);
+  };
+  expectVarSize("first", 4);
+  expectVarSize("pair", 16);
+  expectVarSize("second", 2);
+  expectVarSize("otherPair", 4);
+
+  const auto &debugInfo = dwarfOrErr->getDebugInfo();
+  EXPECT_TRUE(std::is_sorted(
+      debugInfo.begin(), debugInfo.end(),
+      [](const auto &a, const auto &b) { return a.offset < b.offset; }));
+}
+
+TEST_P(DWARFSplit, ReadsOnlyDefiningUnit) {
+  ErrorOr<DWARF> dwarfOrErr =
+      DWARF::readFromObject(*objFileReader, {"second"},
+                            DWARF::ParseMode::VariablesAndTypes, options);
+  ASSERT_TRUE(dwarfOrErr) << dwarfOrErr.getError();
+  EXPECT_EQ(numSplitUnits(*dwarfOrErr), 1u);
+  const Type *type = dwarfOrErr->getVariableType("second");
+  ASSERT_TRUE(type);
+  EXPECT_EQ(type->getObjectSize(), 2u);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    Inputs, DWARFSplit,
+    ::testing::Values("Inputs/Split/Split.so",
+                      "Inputs/SplitPackage/SplitPackage.so"));
+
+TEST(DWARFSplitMissing, Error) {
+  // Without its path the package can't be found.
+  ErrorOr<FileReader> fileReaderOrErr =
+      FileReader::open("Inputs/SplitPackage/SplitPackage.so");
+  ASSERT_TRUE(fileReaderOrErr);
+  std::unique_ptr<ObjectFileReader> objFileReader =
+      createObjectFileReader(std::move(*fileReaderOrErr));
+  ASSERT_NE(objFileReader, nullptr);
+  ErrorOr<DWARF> dwarfOrErr = DWARF::readFromObject(*objFileReader);
+  ASSERT_FALSE(dwarfOrErr);
+  EXPECT_NE(dwarfOrErr.getError().find(".dwo"), std::string::npos);
+}
@@ -0,0 +1,71 @@
+// Copyright 2021 Alex Brachet (alex@brachet.dev)
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cedo/Binfmt/Binfmt.h"
+#include "cedo/Binfmt/DWARF.h"
+#include "cedo/Core/FileReader.h"
+#include "gtest/gtest.h"
+
+// Dwz/main.o has its types and variable names in Dwz/sup.debug, which its
+// .gnu_debugaltlink names.
+struct DWARFSupplementary : public ::testing::Test {
+  std::unique_ptr<ObjectFileReader> objFileReader;
+  DebugFileOptions options;
+
+  void open(const char *path) {
+    options.objectPath = path;
+    ErrorOr<FileReader> fileReaderOrErr = FileReader::open(path);
+    ASSERT_TRUE(fileReaderOrErr);
+
+    objFileReader = createObjectFileReader(std::move(*fileReaderOrErr));
+    ASSERT_NE(objFileReader, nullptr);
+  }
+};
+
+TEST_F(DWARFSupplementary, AltReferences) {
+  open("Inputs/Dwz/main.o");
+  ErrorOr<DWARF> dwarfOrErr =
+      DWARF::readFromObject(*objFileReader, DWARF::ParseMode::Full, options);
+  ASSERT_TRUE(dwarfOrErr) << dwarfOrErr.getError();
+
+  const Type *number = dwarfOrErr->getVariableType("number");
+  ASSERT_NE(number, nullptr);
+  EXPECT_EQ(number->getObjectSize(), 4u);
+
+  const auto *pair =
+      dynamic_cast<const StructType *>(dwarfOrErr->getVariableType("pair"));
+  ASSERT_NE(pair, nullptr);
+  EXPECT_EQ(pair->getObjectSize(), 16u);
+  ASSERT_EQ(pair->members.size(), 2u);
+  EXPECT_EQ(pair->members[0].first, number);
+
+  // Through a DW_FORM_ref_addr in the supplementary file.
+  const auto *next = dynamic_cast<const PointerType *>(pair->members[1].first);
+  ASSERT_NE(next, nullptr);
+  EXPECT_EQ(next->pointingType, pair);
+
+  const auto *head =
+      dynamic_cast<const PointerType *>(dwarfOrErr->getVariableType("head"));
+  ASSERT_NE(head, nullptr);
+  EXPECT_EQ(head->pointingType, pair);
+}
+
+TEST_F(DWARFSupplementary, ByBuildID) {
+  open("Inputs/Dwz/Missing/main.o");
+  EXPECT_FALSE(DWARF::readFromObject(*objFileReader, DWARF::ParseMode::Full,
+                                     options));
+
+  options.debugDirs = {"Inputs/Dwz/debug"};
+  ErrorOr<DWARF> dwarfOrErr =
+      DWARF::readFromObject(*objFileReader, DWARF::ParseMode::Full, options);
+  ASSERT_TRUE(dwarfOrErr) << dwarfOrErr.getError();
+  EXPECT_NE(dwarfOrErr->getVariableType("pair"), nullptr);
+}
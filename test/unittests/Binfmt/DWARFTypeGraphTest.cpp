@@ -0,0 +1,77 @@
+// Copyright 2021 Alex Brachet (alex@brachet.dev)
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cedo/Binfmt/Binfmt.h"
+#include "cedo/Binfmt/DWARF.h"
+#include "cedo/Core/FileReader.h"
+#include "gtest/gtest.h"
+
+struct DWARFTypeGraph : public ::testing::Test {
+  std::unique_ptr<ObjectFileReader> objFileReader;
+  DWARF dwarf;
+
+  void SetUp() override {
+    ErrorOr<FileReader> fileReaderOrErr =
+        FileReader::open("Inputs/LinkedTypes.o");
+    ASSERT_TRUE(fileReaderOrErr);
+
+    objFileReader = createObjectFileReader(std::move(*fileReaderOrErr));
+    ASSERT_NE(objFileReader, nullptr);
+
+    ErrorOr<DWARF> dwarfOrErr = DWARF::readFromObject(*objFileReader);
+    ASSERT_TRUE(dwarfOrErr) << dwarfOrErr.getError();
+
+    dwarf = std::move(*dwarfOrErr);
+  }
+};
+
+TEST_F(DWARFTypeGraph, TypesAreShared) {
+  const Type *head = dwarf.getVariableType("head");
+  ASSERT_NE(head, nullptr);
+  size_t numTypes = dwarf.getTypeGraph()->size();
+  EXPECT_EQ(dwarf.getVariableType("tail"), head);
+  EXPECT_EQ(dwarf.getVariableType("head"), head);
+  EXPECT_EQ(dwarf.getTypeGraph()->size(), numTypes);
+}
+
+TEST_F(DWARFTypeGraph, SelfReferentialStruct) {
+  const auto *node =
+      dynamic_cast<const StructType *>(dwarf.getVariableType("head"));
+  ASSERT_NE(node, nullptr);
+  EXPECT_EQ(node->getObjectSize(), 16u);
+  ASSERT_EQ(node->members.size(), 2u);
+
+  const auto *next = dynamic_cast<const PointerType *>(node->members[1].first);
+  ASSERT_NE(next, nullptr);
+  EXPECT_EQ(next->pointingType, node);
+}
+
+TEST_F(DWARFTypeGraph, VoidPointer) {
+  const auto *opaque =
+      dynamic_cast<const PointerType *>(dwarf.getVariableType("opaque"));
+  ASSERT_NE(opaque, nullptr);
+  EXPECT_EQ(opaque->pointingType, nullptr);
+}
+
+TEST_F(DWARFTypeGraph, OutlivesDWARF) {
+  const Type *head = dwarf.getVariableType("head");
+  ASSERT_NE(head, nullptr);
+  std::shared_ptr<const TypeGraph> types = dwarf.getTypeGraph();
+  dwarf = DWARF{};
+  EXPECT_EQ(head->getObjectSize(), 16u);
+}
+
+// A member whose type can't be read makes the whole struct unreadable, rather
+// than its bytes being left out.
+TEST_F(DWARFTypeGraph, UnresolvableMember) {
+  EXPECT_EQ(dwarf.getVariableType("flexible"), nullptr);
+  EXPECT_NE(dwarf.getVariableType("head"), nullptr);
+}
@@ -0,0 +1,76 @@
+// Copyright 2021 Alex Brachet (alex@brachet.dev)
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+
+#include "cedo/Binfmt/Binfmt.h"
+#include "cedo/Binfmt/DWARF.h"
+#include "cedo/Core/FileReader.h"
+#include "gtest/gtest.h"
+
+// LinkedTypes.c built with -fdebug-types-section, struct Node is in a type
+// unit and head and tail refer to it by signature.
+struct DWARFTypeUnit : public ::testing::TestWithParam<const char *> {
+  std::unique_ptr<ObjectFileReader> objFileReader;
+  DWARF dwarf;
+
+  void SetUp() override {
+    ErrorOr<FileReader> fileReaderOrErr = FileReader::open(GetParam());
+    ASSERT_TRUE(fileReaderOrErr);
+
+    objFileReader = createObjectFileReader(std::move(*fileReaderOrErr));
+    ASSERT_NE(objFileReader, nullptr);
+
+    ErrorOr<DWARF> dwarfOrErr = DWARF::readFromObject(*objFileReader);
+    ASSERT_TRUE(dwarfOrErr) << dwarfOrErr.getError();
+
+    dwarf = std::move(*dwarfOrErr);
+  }
+};
+
+// Type units are only read when a type in them is needed.
+TEST_P(DWARFTypeUnit, NotReadUpFront) {
+  const auto &debugInfo = dwarf.getDebugInfo();
+  EXPECT_EQ(std::count_if(debugInfo.begin(), debugInfo.end(),
+                          [](const auto &die) {
+                            return die.tag == DW_TAG_type_unit ||
+                                   die.tag == DW_TAG_member;
+                          }),
+            0);
+}
+
+TEST_P(DWARFTypeUnit, SelfReferentialStruct) {
+  const auto *node =
+      dynamic_cast<const StructType *>(dwarf.getVariableType("head"));
+  ASSERT_NE(node, nullptr);
+  EXPECT_EQ(node->getObjectSize(), 16u);
+  ASSERT_EQ(node->members.size(), 2u);
+  EXPECT_EQ(node->members[0].first->getObjectSize(), 4u);
+  EXPECT_EQ(node->members[1].second, 8);
+
+  const auto *next = dynamic_cast<const PointerType *>(node->members[1].first);
+  ASSERT_NE(next, nullptr);
+  EXPECT_EQ(next->pointingType, node);
+  EXPECT_EQ(dwarf.getVariableType("tail"), node);
+}
+
+TEST_P(DWARFTypeUnit, VoidPointer) {
+  const auto *opaque =
+      dynamic_cast<const PointerType *>(dwarf.getVariableType("opaque"));
+  ASSERT_NE(opaque, nullptr);
+  EXPECT_EQ(opaque->pointingType, nullptr);
+}
+
+INSTANTIATE_TEST_SUITE_P(Inputs, DWARFTypeUnit,
+                         ::testing::Values("Inputs/TypeUnits/LinkedTypes4.o",
+                                           "Inputs/TypeUnits/LinkedTypes4.so",
+                                           "Inputs/TypeUnits/LinkedTypes5.o",
+                                           "Inputs/TypeUnits/LinkedTypes5.so"));
@@ -0,0 +1,81 @@
+// Copyright 2021 Alex Brachet (alex@brachet.dev)
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+
+#include "cedo/Binfmt/Binfmt.h"
+#include "cedo/Binfmt/DWARF.h"
+#include "cedo/Core/FileReader.h"
+#include "gtest/gtest.h"
+
+// The units from MultiUnit with .debug_pubnames, .gdb_index and .debug_names.
+struct DWARFUnitIndex : public ::testing::TestWithParam<const char *> {
+  std::unique_ptr<ObjectFileReader> objFileReader;
+
+  void SetUp() override {
+    ErrorOr<FileReader> fileReaderOrErr = FileReader::open(GetParam());
+    ASSERT_TRUE(fileReaderOrErr);
+
+    objFileReader = createObjectFileReader(std::move(*fileReaderOrErr));
+    ASSERT_NE(objFileReader, nullptr);
+  }
+
+  size_t numUnitsRead(const std::vector<std::string_view> &names) {
+    ErrorOr<DWARF> dwarfOrErr = DWARF::readFromObject(*objFileReader, names);
+    if (!dwarfOrErr) {
+      ADD_FAILURE() << dwarfOrErr.getError();
+      return 0;
+    }
+    for (std::string_view name : names) {
+      if (name != "notAVariable") {
+        EXPECT_NE(dwarfOrErr->getVariableType(name), nullptr)
+            << "Couldn't find symbol: " << name;
+      }
+    }
+    const auto &debugInfo = dwarfOrErr->getDebugInfo();
+    return std::count_if(debugInfo.begin(), debugInfo.end(),
+                         [](const auto &die) {
+                           return die.tag == DW_TAG_compile_unit;
+                         });
+  }
+};
+
+TEST_P(DWARFUnitIndex, ReadsOnlyDefiningUnit) {
+  EXPECT_EQ(numUnitsRead({"second"}), 1u);
+  EXPECT_EQ(numUnitsRead({"first"}), 1u);
+  EXPECT_EQ(numUnitsRead({"first", "second"}), 2u);
+}
+
+TEST_P(DWARFUnitIndex, MissingNameReadsEveryUnit) {
+  EXPECT_EQ(numUnitsRead({"second", "notAVariable"}), 2u);
+}
+
+INSTANTIATE_TEST_SUITE_P(Inputs, DWARFUnitIndex,
+                         ::testing::Values("Inputs/MultiUnitPubnames.so",
+                                           "Inputs/MultiUnitGdbIndex.so",
+                                           "Inputs/DebugNames.o"));
+
+TEST(DWARFUnitIndexNone, ReadsEveryUnit) {
+  ErrorOr<FileReader> fileReaderOrErr = FileReader::open("Inputs/MultiUnit.so");
+  ASSERT_TRUE(fileReaderOrErr);
+  std::unique_ptr<ObjectFileReader> objFileReader =
+      createObjectFileReader(std::move(*fileReaderOrErr));
+  ASSERT_NE(objFileReader, nullptr);
+
+  ErrorOr<DWARF> dwarfOrErr = DWARF::readFromObject(*objFileReader, {"second"});
+  ASSERT_TRUE(dwarfOrErr) << dwarfOrErr.getError();
+  const auto &debugInfo = dwarfOrErr->getDebugInfo();
+  EXPECT_EQ(std::count_if(debugInfo.begin(), debugInfo.end(),
+                          [](const auto &die) {
+                            return die.tag == DW_TAG_compile_unit;
+                          }),
+            2);
+}
@@ -0,0 +1,120 @@
+// Copyright 2021 Alex Brachet (alex@brachet.dev)
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <filesystem>
+
+#include "cedo/Binfmt/Binfmt.h"
+#include "cedo/Binfmt/DWARF.h"
+#include "cedo/Binfmt/DebugFile.h"
+#include "cedo/Core/FileReader.h"
+#include "gtest/gtest.h"
+
+struct DebugFile : public ::testing::Test {
+  std::unique_ptr<ObjectFileReader> objFileReader;
+  DebugFileOptions options;
+
+  void open(std::string path) {
+    ErrorOr<FileReader> fileReaderOrErr = FileReader::open(path);
+    ASSERT_TRUE(fileReaderOrErr);
+    objFileReader = createObjectFileReader(std::move(*fileReaderOrErr));
+    ASSERT_NE(objFileReader, nullptr);
+    options.objectPath = std::move(path);
+    // Don't find anything installed on the system.
+    options.debugDirs.clear();
+  }
+
+  void expectVariables() {
+    ErrorOr<DWARF> dwarfOrErr =
+        DWARF::readFromObject(*objFileReader, DWARF::ParseMode::Full, options);
+    ASSERT_TRUE(dwarfOrErr) << dwarfOrErr.getError();
+    const Type *first = dwarfOrErr->getVariableType("first");
+    const Type *second = dwarfOrErr->getVariableType("second");
+    ASSERT_TRUE(first);
+    ASSERT_TRUE(second);
+    EXPECT_EQ(first->getObjectSize(), 4u);
+    EXPECT_EQ(second->getObjectSize(), 2u);
+  }
+};
+
+TEST_F(DebugFile, CRC) {
+  const uint8_t check[] = "123456789";
+  EXPECT_EQ(debugLinkCRC32(check, 9), 0xcbf43926u);
+  // Can be computed in pieces.
+  EXPECT_EQ(debugLinkCRC32(check + 4, 5, debugLinkCRC32(check, 4)),
+            0xcbf43926u);
+}
+
+TEST_F(DebugFile, OwnDebugInfo) {
+  open("Inputs/MultiUnit.so");
+  ErrorOr<std::unique_ptr<ObjectFileReader>> debugFileOrErr =
+      openDebugFile(*objFileReader, options);
+  ASSERT_TRUE(debugFileOrErr);
+  EXPECT_EQ(*debugFileOrErr, nullptr);
+}
+
+TEST_F(DebugFile, DebugLink) {
+  open("Inputs/Stripped.so");
+  expectVariables();
+}
+
+TEST_F(DebugFile, DebugLinkBadCRC) {
+  open("Inputs/BadCRC.so");
+  ErrorOr<std::unique_ptr<ObjectFileReader>> debugFileOrErr =
+      openDebugFile(*objFileReader, options);
+  ASSERT_TRUE(debugFileOrErr);
+  EXPECT_EQ(*debugFileOrErr, nullptr);
+  EXPECT_FALSE(DWARF::readFromObject(*objFileReader, DWARF::ParseMode::Full,
+                                     options));
+}
+
+TEST_F(DebugFile, BuildIDDirectory) {
+  open("Inputs/NoDebugLink.so");
+  std::string_view buildID = objFileReader->getBuildID();
+  ASSERT_GE(buildID.size(), 2u);
+  EXPECT_FALSE(DWARF::readFromObject(*objFileReader, DWARF::ParseMode::Full,
+                                     options));
+
+  char hex[3];
+  std::string fileName;
+  for (unsigned char c : buildID) {
+    std::snprintf(hex, sizeof(hex), "%02x", c);
+    fileName += hex;
+  }
+  namespace fs = std::filesystem;
+  fs::path debugDir = fs::path("Inputs") / "debug";
+  fs::path buildIDDir = debugDir / ".build-id" / fileName.substr(0, 2);
+  fs::create_directories(buildIDDir);
+  fs::copy_file("Inputs/Stripped.debug",
+                buildIDDir / (fileName.substr(2) + ".debug"),
+                fs::copy_options::overwrite_existing);
+
+  options.debugDirs = {debugDir};
+  expectVariables();
+}
+
+TEST_F(DebugFile, Explicit) {
+  open("Inputs/NoDebugLink.so");
+  options.debugFile = "Inputs/Stripped.debug";
+  expectVariables();
+}
+
+TEST_F(DebugFile, ExplicitBuildIDMismatch) {
+  open("Inputs/NoDebugLink.so");
+  options.debugFile = "Inputs/MultiUnitGdbIndex.so";
+  ErrorOr<std::unique_ptr<ObjectFileReader>> debugFileOrErr =
+      openDebugFile(*objFileReader, options);
+  if (ErrorOr<FileReader> otherOrErr = FileReader::open(options.debugFile)) {
+    auto other = createObjectFileReader(std::move(*otherOrErr));
+    if (other->getBuildID().empty())
+      GTEST_SKIP() << "Linker didn't add a build ID";
+  }
+  EXPECT_FALSE(debugFileOrErr);
+}
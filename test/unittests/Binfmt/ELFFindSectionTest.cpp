@@ -19,5 +19,17 @@ class FindSection : public ELFReaderTest {};
 
 TEST_F(FindSection, Basic) {
   SetUp("Inputs/Shdr.o");
-  EXPECT_EQ(getReader().getSection(".cedotest"), getFileStart() + 0x2000);
+  EXPECT_EQ(getReader().getSection(".cedotest").data, getFileStart() + 0x2000);
+}
+
+TEST_F(FindSection, Size) {
+  SetUp("Inputs/ResolveReloc.o");
+  ELF::Section section = getReader().getSection(".test_string4");
+  ASSERT_TRUE(section);
+  EXPECT_EQ(section.size, sizeof("bad") + sizeof("String 4"));
+}
+
+TEST_F(FindSection, Missing) {
+  SetUp("Inputs/Shdr.o");
+  EXPECT_FALSE(getReader().getSection(".doesnt_exist"));
 }
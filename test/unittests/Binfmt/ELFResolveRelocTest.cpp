@@ -64,3 +64,23 @@ TEST_F(ResolveReloc, SecOffsetSymOffset) {
   const char *str = reinterpret_cast<const char *>(*locOrErr);
   EXPECT_STREQ(str, "String 4");
 }
+
+TEST_F(ResolveReloc, RelImplicitAddend) {
+  SetUp("Inputs/ResolveRel.o");
+  const ELF::Reader &reader = getReader();
+
+  ErrorOr<const uint8_t *> locOrErr =
+      reader.attemptResolveLocalReloc(".test32", 0);
+  ASSERT_TRUE(locOrErr) << locOrErr.getError();
+  EXPECT_STREQ(reinterpret_cast<const char *>(*locOrErr), "String 4");
+
+  locOrErr = reader.attemptResolveLocalReloc(".test32", 4);
+  ASSERT_TRUE(locOrErr) << locOrErr.getError();
+  EXPECT_STREQ(reinterpret_cast<const char *>(*locOrErr), "bad");
+}
+
+TEST_F(ResolveReloc, NoRelocAtOffset) {
+  SetUp("Inputs/ResolveReloc.o");
+  EXPECT_FALSE(getReader().attemptResolveLocalReloc(".test32", 2));
+  EXPECT_FALSE(getReader().attemptResolveLocalReloc(".test_string0", 0));
+}
@@ -0,0 +1,11 @@
+char one;
+short two;
+int four;
+long eight;
+
+struct Bits {
+  int a : 5;
+  int b : 6;
+  int c : 21;
+  long d;
+} bits;
@@ -0,0 +1,68 @@
+# An object after dwz, with types and strings in sup.debug.
+#
+#   struct Pair pair;
+#   int number;
+#   struct Pair *head;
+
+.section .gnu_debugaltlink,"",@progbits
+    .asciz "sup.debug"
+    .byte 0xd1, 0x0a, 0x1f, 0x20
+
+.section .debug_abbrev,"",@progbits
+    .uleb128 1                  # Abbrev 1
+    .uleb128 0x11               # DW_TAG_compile_unit
+    .byte 1                     # DW_CHILDREN_yes
+    .uleb128 0x13, 0x0b         # DW_AT_language, DW_FORM_data1
+    .uleb128 0, 0
+    .uleb128 2                  # Abbrev 2
+    .uleb128 0x3d               # DW_TAG_imported_unit
+    .byte 0
+    .uleb128 0x18, 0x1f20       # DW_AT_import, DW_FORM_GNU_ref_alt
+    .uleb128 0, 0
+    .uleb128 3                  # Abbrev 3
+    .uleb128 0x34               # DW_TAG_variable
+    .byte 0
+    .uleb128 0x03, 0x1f21       # DW_AT_name, DW_FORM_GNU_strp_alt
+    .uleb128 0x49, 0x1f20       # DW_AT_type, DW_FORM_GNU_ref_alt
+    .uleb128 0x3f, 0x19         # DW_AT_external, DW_FORM_flag_present
+    .uleb128 0, 0
+    .uleb128 4                  # Abbrev 4
+    .uleb128 0x34               # DW_TAG_variable
+    .byte 0
+    .uleb128 0x03, 0x08         # DW_AT_name, DW_FORM_string
+    .uleb128 0x49, 0x13         # DW_AT_type, DW_FORM_ref4
+    .uleb128 0, 0
+    .uleb128 5                  # Abbrev 5
+    .uleb128 0x0f               # DW_TAG_pointer_type
+    .byte 0
+    .uleb128 0x0b, 0x0b         # DW_AT_byte_size, DW_FORM_data1
+    .uleb128 0x49, 0x1f20       # DW_AT_type, DW_FORM_GNU_ref_alt
+    .uleb128 0, 0
+    .byte 0
+
+.section .debug_info,"",@progbits
+.Linfo:
+    .long .Lend - .Lversion
+.Lversion:
+    .short 4
+    .long 0                     # .debug_abbrev offset
+    .byte 8                     # Address size
+    .uleb128 1                  # DW_TAG_compile_unit
+    .byte 0x0c                  # DW_LANG_C99
+    .uleb128 2                  # DW_TAG_imported_unit
+    .long 11
+    .uleb128 3                  # DW_TAG_variable
+    .long 20                    # "pair"
+    .long 18                    # struct Pair
+    .uleb128 3                  # DW_TAG_variable
+    .long 25                    # "number"
+    .long 12                    # int
+    .uleb128 4                  # DW_TAG_variable
+    .asciz "head"
+    .long .Lpointer - .Linfo
+.Lpointer:
+    .uleb128 5                  # DW_TAG_pointer_type
+    .byte 8
+    .long 18                    # struct Pair
+    .byte 0
+.Lend:
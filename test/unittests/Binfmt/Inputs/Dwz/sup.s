@@ -0,0 +1,91 @@
+# A supplementary file like dwz makes: a partial unit with the types its
+# objects share, and their strings.
+#
+#   struct Pair { int first; struct Pair *next; };
+
+.section .note.gnu.build-id,"a",@note
+    .balign 4
+    .long 4                     # n_namesz
+    .long 4                     # n_descsz
+    .long 3                     # NT_GNU_BUILD_ID
+    .asciz "GNU"
+    .byte 0xd1, 0x0a, 0x1f, 0x20
+
+.section .debug_abbrev,"",@progbits
+    .uleb128 1                  # Abbrev 1
+    .uleb128 0x3c               # DW_TAG_partial_unit
+    .byte 1                     # DW_CHILDREN_yes
+    .uleb128 0, 0
+    .uleb128 2                  # Abbrev 2
+    .uleb128 0x24               # DW_TAG_base_type
+    .byte 0
+    .uleb128 0x03, 0x0e         # DW_AT_name, DW_FORM_strp
+    .uleb128 0x0b, 0x0b         # DW_AT_byte_size, DW_FORM_data1
+    .uleb128 0, 0
+    .uleb128 3                  # Abbrev 3
+    .uleb128 0x13               # DW_TAG_structure_type
+    .byte 1
+    .uleb128 0x03, 0x0e         # DW_AT_name, DW_FORM_strp
+    .uleb128 0x0b, 0x0b         # DW_AT_byte_size, DW_FORM_data1
+    .uleb128 0, 0
+    .uleb128 4                  # Abbrev 4
+    .uleb128 0x0d               # DW_TAG_member
+    .byte 0
+    .uleb128 0x03, 0x0e         # DW_AT_name, DW_FORM_strp
+    .uleb128 0x49, 0x13         # DW_AT_type, DW_FORM_ref4
+    .uleb128 0x38, 0x0b         # DW_AT_data_member_location, DW_FORM_data1
+    .uleb128 0, 0
+    .uleb128 5                  # Abbrev 5
+    .uleb128 0x0f               # DW_TAG_pointer_type
+    .byte 0
+    .uleb128 0x0b, 0x0b         # DW_AT_byte_size, DW_FORM_data1
+    .uleb128 0x49, 0x10         # DW_AT_type, DW_FORM_ref_addr
+    .uleb128 0, 0
+    .byte 0
+
+# The objects refer to int at offset 12 and struct Pair at 18.
+.section .debug_info,"",@progbits
+.Linfo:
+    .long .Lend - .Lversion
+.Lversion:
+    .short 4
+    .long 0                     # .debug_abbrev offset
+    .byte 8                     # Address size
+    .uleb128 1                  # DW_TAG_partial_unit
+.Lint:
+    .uleb128 2                  # DW_TAG_base_type
+    .long .Lstr_int - .Lstr
+    .byte 4
+.Lpair:
+    .uleb128 3                  # DW_TAG_structure_type
+    .long .Lstr_Pair - .Lstr
+    .byte 16
+    .uleb128 4                  # DW_TAG_member
+    .long .Lstr_first - .Lstr
+    .long .Lint - .Linfo
+    .byte 0
+    .uleb128 4                  # DW_TAG_member
+    .long .Lstr_next - .Lstr
+    .long .Lpointer - .Linfo
+    .byte 8
+    .byte 0
+.Lpointer:
+    .uleb128 5                  # DW_TAG_pointer_type
+    .byte 8
+    .long .Lpair - .Linfo
+    .byte 0
+.Lend:
+
+# The objects' variable names are here too, at offsets 20 and 25.
+.section .debug_str,"MS",@progbits,1
+.Lstr:
+.Lstr_int:
+    .asciz "int"
+.Lstr_Pair:
+    .asciz "Pair"
+.Lstr_first:
+    .asciz "first"
+.Lstr_next:
+    .asciz "next"
+    .asciz "pair"
+    .asciz "number"
@@ -0,0 +1,31 @@
+struct Point {
+  int x;
+  int y;
+};
+
+short counter;
+
+// Whichever function ends up last in .debug_info has no DW_AT_sibling, so
+// skipping it walks its children instead.
+
+int sum(int a, int b) {
+  static long counter;
+  counter++;
+  int total = a + b;
+  {
+    struct Point local = {total, total};
+    total += local.y;
+  }
+  return total;
+}
+
+struct Point origin;
+
+long last(long a) {
+  long b = a * 2;
+  {
+    char c = 1;
+    b += c;
+  }
+  return b;
+}
@@ -0,0 +1,15 @@
+struct Node {
+  int value;
+  struct Node *next;
+};
+
+struct Node head;
+struct Node tail;
+void *opaque;
+
+struct Flexible {
+  int size;
+  int values[];
+};
+
+struct Flexible flexible;
@@ -0,0 +1,9 @@
+struct Pair {
+  long a;
+  long b;
+};
+
+int first;
+struct Pair pair;
+
+long sumPair(struct Pair p) { return p.a + p.b; }
@@ -0,0 +1,8 @@
+// A different Pair than first.c's, references to it are relative to this
+// unit.
+struct Pair {
+  int a;
+};
+
+short second;
+struct Pair otherPair;
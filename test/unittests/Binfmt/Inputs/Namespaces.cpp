@@ -0,0 +1,14 @@
+namespace ns {
+int table;
+
+namespace inner {
+long value;
+} // namespace inner
+} // namespace ns
+
+struct S {
+  static short member;
+};
+short S::member;
+
+int global;
@@ -0,0 +1,50 @@
+// Copyright 2021 Alex Brachet (alex@brachet.dev)
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <chrono>
+#include <cstdio>
+
+#include "cedo/Binfmt/Binfmt.h"
+#include "cedo/Binfmt/DWARF.h"
+#include "cedo/Core/FileReader.h"
+#include "lib/Binfmt/ELF.h"
+
+#include "gtest/gtest.h"
+
+// Counts how many section lookups parsing debug info takes. BasicTypes.o is a
+// relocatable object so every strp goes through attemptResolveLocalReloc,
+// which shouldn't need to look up any sections.
+TEST(SectionLookupBench, LookupsPerParse) {
+  ErrorOr<FileReader> fileReaderOrErr = FileReader::open("Inputs/BasicTypes.o");
+  ASSERT_TRUE(fileReaderOrErr);
+
+  std::unique_ptr<ELF::Reader> reader =
+      ELF::Reader::create(std::move(*fileReaderOrErr));
+  ASSERT_TRUE(reader);
+
+  constexpr int numParses = 1000;
+  size_t lookupsBefore = reader->getNumSectionLookups();
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < numParses; i++) {
+    ErrorOr<DWARF> dwarfOrErr = DWARF::readFromObject(*reader);
+    ASSERT_TRUE(dwarfOrErr) << dwarfOrErr.getError();
+  }
+  auto elapsed = std::chrono::steady_clock::now() - start;
+
+  size_t lookupsPerParse =
+      (reader->getNumSectionLookups() - lookupsBefore) / numParses;
+  std::printf(
+      "[ BENCH    ] %zu section lookups per parse, %.2f us per parse\n",
+      lookupsPerParse,
+      std::chrono::duration<double, std::micro>(elapsed).count() / numParses);
+
+  EXPECT_LE(lookupsPerParse, 3u);
+}
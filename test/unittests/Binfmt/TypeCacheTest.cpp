@@ -0,0 +1,101 @@
+// Copyright 2021 Alex Brachet (alex@brachet.dev)
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <fstream>
+
+#include "cedo/Binfmt/Binfmt.h"
+#include "cedo/Binfmt/DWARF.h"
+#include "cedo/Binfmt/TypeCache.h"
+#include "cedo/Core/FileReader.h"
+#include "gtest/gtest.h"
+
+static std::unique_ptr<ObjectFileReader> openObject(const char *path) {
+  ErrorOr<FileReader> fileReaderOrErr = FileReader::open(path);
+  if (!fileReaderOrErr)
+    return nullptr;
+  return createObjectFileReader(std::move(*fileReaderOrErr));
+}
+
+TEST(TypeCache, RoundTrip) {
+  std::unique_ptr<ObjectFileReader> objFileReader =
+      openObject("Inputs/LinkedTypes.o");
+  ASSERT_NE(objFileReader, nullptr);
+  ErrorOr<DWARF> dwarfOrErr = DWARF::readFromObject(*objFileReader);
+  ASSERT_TRUE(dwarfOrErr) << dwarfOrErr.getError();
+
+  std::vector<TypeCache::Variable> variables;
+  for (const char *name : {"head", "tail", "opaque"})
+    variables.push_back({name, name, dwarfOrErr->getVariableType(name)});
+  ASSERT_EQ(TypeCache::write("RoundTrip.cedo-cache", variables), "");
+
+  ErrorOr<TypeCache> cacheOrErr = TypeCache::open("RoundTrip.cedo-cache");
+  ASSERT_TRUE(cacheOrErr) << cacheOrErr.getError();
+  EXPECT_FALSE(cacheOrErr->find("doesnt_exist"));
+
+  std::optional<TypeCache::Variable> head = cacheOrErr->find("head");
+  ASSERT_TRUE(head);
+  EXPECT_EQ(head->linkageName, "head");
+  const auto *node = dynamic_cast<const StructType *>(head->type);
+  ASSERT_NE(node, nullptr);
+  EXPECT_EQ(node->getObjectSize(), 16u);
+  ASSERT_EQ(node->members.size(), 2u);
+  EXPECT_EQ(node->members[0].first->getObjectSize(), 4u);
+  EXPECT_EQ(node->members[1].second, 8);
+  const auto *next = dynamic_cast<const PointerType *>(node->members[1].first);
+  ASSERT_NE(next, nullptr);
+  EXPECT_EQ(next->pointingType, node);
+
+  std::optional<TypeCache::Variable> tail = cacheOrErr->find("tail");
+  ASSERT_TRUE(tail);
+  EXPECT_EQ(tail->type, head->type);
+
+  std::optional<TypeCache::Variable> opaque = cacheOrErr->find("opaque");
+  ASSERT_TRUE(opaque);
+  ASSERT_TRUE(opaque->type->isPointer());
+  EXPECT_EQ(static_cast<const PointerType *>(opaque->type)->pointingType,
+            nullptr);
+
+  EXPECT_EQ(cacheOrErr->getVariables().size(), 3u);
+}
+
+TEST(TypeCache, RejectsInvalidFile) {
+  {
+    std::ofstream out{"Invalid.cedo-cache", std::ios::binary};
+    out << "CEDOTC2 but not really a cache file";
+  }
+  EXPECT_FALSE(TypeCache::open("Invalid.cedo-cache"));
+
+  // Files from before records were padded to 8 bytes have the old magic.
+  ASSERT_EQ(TypeCache::write("OldVersion.cedo-cache", {}), "");
+  EXPECT_TRUE(TypeCache::open("OldVersion.cedo-cache"));
+  {
+    std::fstream file{"OldVersion.cedo-cache",
+                      std::ios::binary | std::ios::in | std::ios::out};
+    file.seekp(6);
+    file.put('1');
+  }
+  EXPECT_FALSE(TypeCache::open("OldVersion.cedo-cache"));
+  EXPECT_FALSE(TypeCache::open("DoesntExist.cedo-cache"));
+}
+
+TEST(TypeCache, FileName) {
+  std::unique_ptr<ObjectFileReader> linked = openObject("Inputs/MultiUnit.so");
+  ASSERT_NE(linked, nullptr);
+  EXPECT_FALSE(linked->getBuildID().empty());
+  std::string name = TypeCache::getFileName(*linked);
+  EXPECT_EQ(name.size(), linked->getBuildID().size() * 2 + 11);
+
+  // Relocatable objects don't have a build ID.
+  std::unique_ptr<ObjectFileReader> object = openObject("Inputs/LinkedTypes.o");
+  ASSERT_NE(object, nullptr);
+  EXPECT_TRUE(object->getBuildID().empty());
+  EXPECT_EQ(TypeCache::getFileName(*object).rfind("hash-", 0), 0u);
+}
@@ -0,0 +1,45 @@
+// Copyright 2021 Alex Brachet (alex@brachet.dev)
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstdint>
+
+#include "cedo/Core/Arena.h"
+#include "gtest/gtest.h"
+
+TEST(Arena, Alignment) {
+  Arena arena;
+  arena.allocate<char>(3);
+  auto *i = arena.allocate<uint64_t>();
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(i) % alignof(uint64_t), 0u);
+  auto *c = arena.allocate<char>();
+  EXPECT_EQ(reinterpret_cast<char *>(i) + sizeof(uint64_t), c);
+}
+
+TEST(Arena, Oversized) {
+  Arena arena;
+  auto *small = arena.allocate<int>();
+  *small = 1;
+  auto *large = arena.allocate<char>(1 << 20);
+  large[(1 << 20) - 1] = 'a';
+  // The oversized allocation shouldn't have moved on from the first slab.
+  EXPECT_EQ(arena.allocate<int>(), small + 1);
+  EXPECT_GE(arena.getBytesAllocated(), size_t{1 << 20});
+}
+
+TEST(Arena, MoveKeepsAllocations) {
+  Arena arena;
+  int *i = arena.allocate<int>();
+  *i = 42;
+  Arena moved = std::move(arena);
+  EXPECT_EQ(*i, 42);
+  EXPECT_EQ(arena.getBytesAllocated(), 0u);
+  EXPECT_NE(moved.allocate<int>(), arena.allocate<int>());
+}
@@ -0,0 +1,108 @@
+// Copyright 2021 Alex Brachet (alex@brachet.dev)
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <string>
+
+#include "cedo/Core/Error.h"
+#include "cedo/Core/ErrorOr.h"
+#include "gtest/gtest.h"
+
+static size_t numAllocations = 0;
+
+void *operator new(size_t size) {
+  numAllocations++;
+  if (void *ptr = std::malloc(size ? size : 1))
+    return ptr;
+  std::abort();
+}
+
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+void operator delete(void *ptr, size_t) noexcept { std::free(ptr); }
+
+TEST(Error, Success) {
+  Error err;
+  EXPECT_FALSE(err);
+  EXPECT_EQ(err.getCode(), Error::Code::Success);
+  EXPECT_EQ(err.getMessage(), "");
+}
+
+TEST(Error, Format) {
+  std::string_view name = ".debug_info";
+  Error err = Error::notFound("Couldn't find section '{}'", name);
+  EXPECT_TRUE(err);
+  EXPECT_EQ(err.getCode(), Error::Code::NotFound);
+  EXPECT_EQ(err.getMessage(), "Couldn't find section '.debug_info'");
+
+  err = Error::malformed("Unit at '{}' has size {}", uint64_t{16}, 4);
+  EXPECT_EQ(err.getCode(), Error::Code::Malformed);
+  EXPECT_EQ(err.getMessage(), "Unit at '16' has size 4");
+
+  // Placeholders past the arguments are left alone.
+  err = Error::unsupported("{} {} {}", 1, 2);
+  EXPECT_EQ(err.getMessage(), "1 2 {}");
+}
+
+TEST(Error, Message) {
+  Error err = std::string{"Couldn't open file"};
+  EXPECT_EQ(err.getCode(), Error::Code::Other);
+  EXPECT_EQ(err.getMessage(), "Couldn't open file");
+
+  err = Error("No such file", Error::Code::NotFound);
+  EXPECT_EQ(err.getCode(), Error::Code::NotFound);
+  EXPECT_EQ(err.getMessage(), "No such file");
+}
+
+TEST(Error, ErrorOr) {
+  auto find = [](bool found) -> ErrorOr<int> {
+    if (!found)
+      return Error::notFound("Couldn't find relocation at offset '{}'", 8);
+    return 1;
+  };
+  ErrorOr<int> valueOrErr = find(true);
+  ASSERT_TRUE(valueOrErr);
+  EXPECT_EQ(*valueOrErr, 1);
+  EXPECT_FALSE(valueOrErr.takeError());
+
+  ErrorOr<int> errOrValue = find(false);
+  ASSERT_FALSE(errOrValue);
+  EXPECT_EQ(errOrValue.takeError().getCode(), Error::Code::NotFound);
+  EXPECT_EQ(errOrValue.getError(), "Couldn't find relocation at offset '8'");
+
+  // Errors passed on keep their code.
+  auto forward = [&]() -> ErrorOr<long> {
+    ErrorOr<int> valueOrErr = find(false);
+    if (!valueOrErr)
+      return valueOrErr.takeError();
+    return *valueOrErr;
+  };
+  EXPECT_EQ(forward().takeError().getCode(), Error::Code::NotFound);
+}
+
+// Lookups that fail and are checked, not printed, shouldn't allocate.
+TEST(Error, NoAllocations) {
+  auto find = [](uint64_t offset) -> ErrorOr<const uint8_t *> {
+    return Error::notFound("Couldn't find relocation at offset '{}'", offset);
+  };
+  size_t before = numAllocations;
+  size_t numFound = 0;
+  for (uint64_t i = 0; i < 100; i++) {
+    ErrorOr<const uint8_t *> valueOrErr = find(i);
+    if (valueOrErr)
+      numFound++;
+    else if (valueOrErr.takeError().getCode() != Error::Code::NotFound)
+      numFound--;
+  }
+  EXPECT_EQ(numAllocations, before);
+  EXPECT_EQ(numFound, 0u);
+}
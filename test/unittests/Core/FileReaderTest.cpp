@@ -9,7 +9,12 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <unistd.h>
+
+#include <cstdlib>
 #include <fstream>
+#include <string>
+#include <string_view>
 
 #include "cedo/Core/FileReader.h"
 #include "gtest/gtest.h"
@@ -30,3 +35,32 @@ TEST(FileReader, ReadBasicFile) {
   ASSERT_EQ(file->getFileSize(), 4);
   ASSERT_STREQ(file->getFileBuffer(), "text");
 }
+
+TEST(FileReader, LazyMapping) {
+  std::string contents(3 * 4096 + 100, 'a');
+  for (size_t i = 0; i < contents.size(); i++)
+    contents[i] = 'a' + i % 26;
+  const char *tmpDir = std::getenv("TMPDIR");
+  std::string path =
+      std::string{tmpDir && *tmpDir ? tmpDir : "/tmp"} + "/cedo-lazy-XXXXXX";
+  int fd = ::mkstemp(path.data());
+  ASSERT_GE(fd, 0);
+  ASSERT_EQ(::write(fd, contents.data(), contents.size()),
+            static_cast<ssize_t>(contents.size()));
+  ::close(fd);
+
+  ErrorOr<FileReader> file = FileReader::open(path, FileReader::MapMode::Lazy);
+  // The mapping keeps the file's contents around after it's unlinked.
+  ::unlink(path.c_str());
+  ASSERT_TRUE(file);
+  ASSERT_EQ(file->getFileSize(), contents.size());
+
+  // Dropped pages are read back from the file.
+  const char *middle = file->getFileBuffer() + 100;
+  file->willNeed(middle, 2 * 4096);
+  EXPECT_EQ(std::string_view(middle, 2 * 4096),
+            std::string_view(contents).substr(100, 2 * 4096));
+  file->dontNeed(file->getFileBuffer(), file->getFileSize());
+  EXPECT_EQ(std::string_view(file->getFileBuffer(), file->getFileSize()),
+            contents);
+}
@@ -0,0 +1,90 @@
+// Copyright 2021 Alex Brachet (alex@brachet.dev)
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "cedo/Core/LEB128.h"
+#include "gtest/gtest.h"
+
+// Values shaped like those in .debug_info: mostly one or two bytes, like
+// abbrev codes, line numbers and small constants, with some longer ones.
+static std::vector<uint8_t> makeValues(size_t count) {
+  std::vector<uint8_t> bytes;
+  uint32_t state = 1;
+  for (size_t i = 0; i < count; i++) {
+    state = state * 1103515245 + 12345;
+    uint64_t value = (state >> 8) % 4 ? (state >> 16) % 300
+                                      : uint64_t{state} << (state % 24);
+    do {
+      uint8_t byte = value & 0x7f;
+      value >>= 7;
+      bytes.push_back(value ? byte | 0x80 : byte);
+    } while (value);
+  }
+  return bytes;
+}
+
+template <typename F> static double timeNs(size_t count, F f) {
+  auto start = std::chrono::steady_clock::now();
+  f();
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  return std::chrono::duration<double, std::nano>(elapsed).count() / count;
+}
+
+TEST(LEB128Bench, Decode) {
+  constexpr size_t numValues = 1 << 20;
+  std::vector<uint8_t> bytes = makeValues(numValues);
+
+  uint64_t bytewiseSum = 0, sum = 0;
+  double bytewiseNs = timeNs(numValues, [&] {
+    const uint8_t *ptr = bytes.data();
+    for (size_t i = 0; i < numValues; i++)
+      bytewiseSum += readULEB128Bytewise(ptr);
+  });
+  double ns = timeNs(numValues, [&] {
+    const uint8_t *ptr = bytes.data();
+    for (size_t i = 0; i < numValues; i++)
+      sum += readULEB128(ptr);
+  });
+  std::printf("[ BENCH    ] ULEB128 decode: %.2f ns bytewise, %.2f ns\n",
+              bytewiseNs, ns);
+  EXPECT_EQ(sum, bytewiseSum);
+}
+
+TEST(LEB128Bench, Skip) {
+  // Like the runs of DW_FORM_udata and DW_FORM_sdata attributes in a DIE.
+  constexpr size_t runLength = 6;
+  // A whole number of runs, so the last one doesn't read past the end.
+  constexpr size_t numValues = (1 << 20) / runLength * runLength;
+  std::vector<uint8_t> bytes = makeValues(numValues);
+
+  const uint8_t *bytewiseEnd, *end;
+  double bytewiseNs = timeNs(numValues, [&] {
+    const uint8_t *ptr = bytes.data();
+    for (size_t i = 0; i < numValues; i += runLength)
+      skipLEB128sBytewise(ptr, runLength);
+    bytewiseEnd = ptr;
+  });
+  double ns = timeNs(numValues, [&] {
+    const uint8_t *ptr = bytes.data();
+    for (size_t i = 0; i < numValues; i += runLength)
+      skipLEB128s(ptr, runLength);
+    end = ptr;
+  });
+  std::printf("[ BENCH    ] LEB128 skip, %zu at a time: %.2f ns bytewise, "
+              "%.2f ns per value\n",
+              runLength, bytewiseNs, ns);
+  EXPECT_EQ(end, bytewiseEnd);
+  EXPECT_EQ(end, bytes.data() + bytes.size());
+}
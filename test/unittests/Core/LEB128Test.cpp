@@ -0,0 +1,115 @@
+// Copyright 2021 Alex Brachet (alex@brachet.dev)
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstdint>
+#include <vector>
+
+#include "cedo/Core/LEB128.h"
+#include "gtest/gtest.h"
+
+TEST(LEB128, Unsigned) {
+  // Examples from the DWARF 4 standard, section 7.6.
+  const uint8_t bytes[]{2, 127, 0x80, 1, 0x81, 1, 0x82, 1, 0xb9, 100};
+  const uint8_t *ptr = bytes;
+  EXPECT_EQ(readULEB128(ptr), 2u);
+  EXPECT_EQ(readULEB128(ptr), 127u);
+  EXPECT_EQ(readULEB128(ptr), 128u);
+  EXPECT_EQ(readULEB128(ptr), 129u);
+  EXPECT_EQ(readULEB128(ptr), 130u);
+  EXPECT_EQ(readULEB128(ptr), 12857u);
+  EXPECT_EQ(ptr, bytes + sizeof(bytes));
+}
+
+TEST(LEB128, Signed) {
+  const uint8_t bytes[]{2, 0x7e, 0xff, 0, 0x81, 0x7f, 0x80, 1, 0x80, 0x7f};
+  const uint8_t *ptr = bytes;
+  EXPECT_EQ(readSLEB128(ptr), 2);
+  EXPECT_EQ(readSLEB128(ptr), -2);
+  EXPECT_EQ(readSLEB128(ptr), 127);
+  EXPECT_EQ(readSLEB128(ptr), -127);
+  EXPECT_EQ(readSLEB128(ptr), 128);
+  EXPECT_EQ(readSLEB128(ptr), -128);
+  EXPECT_EQ(ptr, bytes + sizeof(bytes));
+}
+
+TEST(LEB128, Skip) {
+  const uint8_t bytes[]{0x80, 0x80, 0x80, 1, 5};
+  const uint8_t *ptr = bytes;
+  skipLEB128(ptr);
+  EXPECT_EQ(ptr, bytes + 4);
+  skipLEB128(ptr);
+  EXPECT_EQ(ptr, bytes + 5);
+}
+
+// Encodes values of every length, including ones longer than 64 bits.
+static std::vector<uint8_t> encodeAll(std::vector<uint64_t> &values,
+                                      bool isSigned) {
+  std::vector<uint8_t> bytes;
+  uint64_t state = 0x9e3779b97f4a7c15;
+  for (int i = 0; i < 2000; i++) {
+    state = state * 6364136223846793005 + 1442695040888963407;
+    uint64_t value = state >> (i % 64);
+    if (isSigned && i % 3 == 0)
+      value = -value;
+    values.push_back(value);
+    int64_t signedValue = static_cast<int64_t>(value);
+    for (;;) {
+      uint8_t byte = value & 0x7f;
+      value = isSigned ? static_cast<uint64_t>(signedValue >>= 7) : value >> 7;
+      bool done = isSigned ? (signedValue == 0 && !(byte & 0x40)) ||
+                                 (signedValue == -1 && (byte & 0x40))
+                           : value == 0;
+      bytes.push_back(done ? byte : byte | 0x80);
+      if (done)
+        break;
+    }
+    // Redundant padding bytes, which some producers emit.
+    if (i % 50 == 0 && !isSigned) {
+      bytes.back() |= 0x80;
+      bytes.insert(bytes.end(), {0x80, 0x80, 0x80, 0x80, 0x80, 0});
+    }
+  }
+  return bytes;
+}
+
+TEST(LEB128, MatchesBytewise) {
+  for (bool isSigned : {false, true}) {
+    std::vector<uint64_t> values;
+    std::vector<uint8_t> bytes = encodeAll(values, isSigned);
+    const uint8_t *ptr = bytes.data();
+    const uint8_t *bytewisePtr = bytes.data();
+    for (uint64_t value : values) {
+      if (isSigned) {
+        EXPECT_EQ(readSLEB128(ptr), readSLEB128Bytewise(bytewisePtr));
+        EXPECT_EQ(ptr, bytewisePtr);
+      } else {
+        EXPECT_EQ(readULEB128(ptr), value);
+        readULEB128Bytewise(bytewisePtr);
+        EXPECT_EQ(ptr, bytewisePtr);
+      }
+    }
+    EXPECT_EQ(ptr, bytes.data() + bytes.size());
+  }
+}
+
+TEST(LEB128, SkipMany) {
+  std::vector<uint64_t> values;
+  std::vector<uint8_t> bytes = encodeAll(values, false);
+  for (size_t count : {1, 2, 7, 16, 33, 500}) {
+    const uint8_t *ptr = bytes.data();
+    const uint8_t *bytewisePtr = bytes.data();
+    for (size_t i = 0; i + count <= values.size(); i += count) {
+      skipLEB128s(ptr, count);
+      skipLEB128sBytewise(bytewisePtr, count);
+      ASSERT_EQ(ptr, bytewisePtr) << count << " at a time";
+    }
+  }
+}
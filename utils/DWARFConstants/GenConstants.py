@@ -51,6 +51,11 @@ def emit_as_array(type_name):
 
 
 def emit_get_from_value(type_name, value_type):
+    print(f"constexpr bool is_DW_{type_name}(decltype(DW_{type_name}::value) value) {{")
+    print(f"  for (const auto &a : DW_{type_name}_static_list)")
+    print(f"    if (a.value == value) return true;")
+    print("  return false;")
+    print("}\n")
     print(f"constexpr DW_{type_name} get_DW_{type_name}(decltype(DW_{type_name}::value) value) {{")
     print(f"  for (const auto &a : DW_{type_name}_static_list)")
     print(f"    if (a.value == value) return a;")